@@ -0,0 +1,93 @@
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Times FullEnsembleTrainer::computeModelAverages for each
+// full_engine on the same random model, and reports the
+// largest deviation of m1/m2 from the first engine listed
+// (by default the per-state "enumeration" path).
+// An engine may carry an enum_precision, "enumeration:float";
+// q < 1 exercises the support cutoff ("pruned").
+//
+//   usage: bench_full_ensemble [nspins=18] [repeats=3] [triplets=0] [q=1]
+//                              [engine[:precision] ...]
+// --------------------------------------------------------
+int main(int argc, char **argv)
+{
+    auto logger = getLogger();
+    logger->set_level(spdlog::level::warn);
+
+    int nspins    = argc > 1 ? std::stoi(argv[1]) : 18;
+    int repeats   = argc > 2 ? std::stoi(argv[2]) : 3;
+    bool triplets = argc > 3 ? std::stoi(argv[3]) != 0 : false;
+    double q_val  = argc > 4 ? std::stod(argv[4]) : 1.0;
+    std::vector<std::string> engines;
+    for (int a = 5; a < argc; ++a)
+        engines.push_back(argv[a]);
+    if (engines.empty())
+        engines = {"enumeration", "enumeration:float", "wht", "gray", "blocked"};
+
+    // a trainer needs data: a few random samples are enough here
+    auto data_file = std::filesystem::temp_directory_path() / "bench_full_ensemble.csv";
+    {
+        std::ofstream out(data_file);
+        std::mt19937 rng(1);
+        for (int r = 0; r < 100; ++r)
+            for (int i = 0; i < nspins; ++i)
+                out << ((rng() & 1) ? 1 : -1) << (i + 1 < nspins ? "," : "\n");
+    }
+
+    MaxEntCore core(nspins, "bench");
+    std::mt19937 rng(2);
+    std::normal_distribution<double> dist(0.0, 1.0 / std::sqrt(nspins));
+
+    std::cout << "nspins=" << nspins << " repeats=" << repeats << " triplets=" << triplets
+              << " q=" << q_val << " kernels=" << core.kernelName() << "\n";
+    std::cout << "engine,seconds_per_call,max_dev_m1,max_dev_m2\n";
+
+    arma::Col<double> m1_ref, m2_ref;
+    for (const auto &engine : engines)
+    {
+        RunParameters params;
+        params.run_type    = "Full_Ensemble";
+        params.nspins      = nspins;
+        params.q_val       = q_val;
+        params.full_engine = engine.substr(0, engine.find(':'));
+        if (engine.find(':') != std::string::npos)
+            params.enum_precision = engine.substr(engine.find(':') + 1);
+        FullEnsembleTrainer model(core, params, data_file.string());
+
+        // same random model for every engine
+        rng.seed(2);
+        dist.reset();
+        for (auto &x : core.h)
+            x = dist(rng);
+        for (auto &x : core.J)
+            x = dist(rng);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+            model.computeModelAverages(1.0, triplets);
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / repeats;
+
+        if (m1_ref.is_empty())
+        {
+            m1_ref = model.get_m1_model();
+            m2_ref = model.get_m2_model();
+        }
+        double dev_m1 = arma::max(arma::abs(model.get_m1_model() - m1_ref));
+        double dev_m2 = arma::max(arma::abs(model.get_m2_model() - m2_ref));
+
+        std::cout << engine << "," << seconds << "," << dev_m1 << "," << dev_m2 << "\n";
+    }
+
+    return 0;
+}
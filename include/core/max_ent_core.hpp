@@ -1,6 +1,9 @@
 #pragma once
+#include "utils/coupling_matrix.hpp"
 #include "utils/get_logger.hpp"
+#include "utils/spin_kernels.hpp"
 #include <armadillo>
+#include <cmath>
 #include <string>
 class MaxEntCore
 {
@@ -16,6 +19,11 @@ class MaxEntCore
     // k-pairwise
     arma::Col<double> K;
 
+    // J as dense symmetric matrices, in double and float, for the local fields of the
+    // samplers (one contiguous dot product per field); kept equal to J by syncCouplings
+    utils::CouplingMatrix<double> J_dense;
+    utils::CouplingMatrix<float> J_dense_f;
+
     MaxEntCore(size_t n, const std::string &runid_) : nspins(n), runid(runid_)
     {
         nedges = nspins * (nspins - 1) / 2;
@@ -37,5 +45,66 @@ class MaxEntCore
         // k-pairwise
         K.set_size(nspins+1);
         K.fill(0);
+
+        syncCouplings();
     };
-};
\ No newline at end of file
+
+    /**
+     * @brief Copies the entries of J that changed since the last call into J_dense and
+     * J_dense_f.
+     *
+     * Called after every parameter update, and by the samplers before they read J_dense
+     * (J is public and may have been set directly). One O(n^2) pass; a coordinate-descent
+     * step that moved a single J_ij writes one pair of entries.
+     */
+    void syncCouplings()
+    {
+        if (J_dense.size() != nspins || J_synced.n_elem != J.n_elem)
+        {
+            J_dense.resize(nspins);
+            J_dense_f.resize(nspins);
+            J_synced.zeros(J.n_elem);
+        }
+        for (int i = 0; i < nspins - 1; ++i)
+        {
+            for (int j = i + 1; j < nspins; ++j)
+            {
+                const int ij = edges(i, j);
+                if (J(ij) != J_synced(ij))
+                {
+                    J_dense.set(i, j, J(ij));
+                    J_dense_f.set(i, j, J(ij));
+                    J_synced(ij) = J(ij);
+                }
+            }
+        }
+    }
+
+    // largest |E| of any state: sum |h| + sum |J| + max |K|
+    double energyBound() const
+    {
+        double bound = arma::accu(arma::abs(h)) + arma::accu(arma::abs(J));
+        return K.is_empty() ? bound : bound + arma::max(arma::abs(K));
+    }
+
+    // largest |round(E / energy_bin)| of any state, plus one bin for rounding
+    int energyBinBound(double energy_bin) const
+    {
+        return static_cast<int>(std::ceil(energyBound() / energy_bin)) + 1;
+    }
+
+    // energy, local-field and moment kernels compiled for nspins (utils/spin_kernels.hpp)
+    const utils::SpinKernels &kernels() const
+    {
+        return utils::spinKernels(nspins);
+    }
+
+    // the specialization kernels() selected, "n=16" or "generic", for logs and benchmarks
+    std::string kernelName() const
+    {
+        return utils::spinKernelName(nspins);
+    }
+
+  private:
+    arma::Col<double> J_synced; // J as last copied into J_dense
+};
@@ -14,6 +14,8 @@ struct RunParameters
                                             // "Temperature_Dep": Run temperature dependence for
                                             // trained model. "Gen_Full": Generate means n<=20,
                                             // "Gen_MC": Generate means n>20
+                                            // "Full_Shard": enumerate one shard of the states,
+                                            // "Full_Merge": reduce the shard files to a model
     std::string ver                = "1.1";
     int continue_run               = 0;
     bool reset_fields              = false;
@@ -26,6 +28,34 @@ struct RunParameters
     double q_val           = 1.0;
     double beta            = 1.0;
     int iter               = 1;
+
+    // full ensemble engine: "enumeration" sums state by state, "wht" uses Walsh-Hadamard
+    // transforms of the energy and of P(s) (O(n 2^n), needs 2^n doubles), "gray" walks the
+    // states in Gray-code order with O(n) energy updates, "blocked" sweeps precomputed
+    // inner-block energy tables for every outer prefix, "pruned" (q < 1) skips the subtrees
+    // of a depth-first walk that lie outside the support of the Tsallis weights, "sectors"
+    // enumerates each magnetization sector separately and keeps its Z_k, m1 and m2
+    std::string full_engine = "enumeration";
+
+    // keep the pairwise energies of all 2^n states between iterations ("none", "double",
+    // "float"), patched with the h/J deltas; used by the "enumeration", "wht" and "sectors"
+    // engines
+    std::string energy_cache = "none";
+
+    // full enumeration (n <= 40) runs in chunks of 2^enum_chunk_log2 states ("sectors": pieces
+    // of at most that many states per magnetization sector)
+    int enum_chunk_log2 = 22;
+    // arithmetic of the "enumeration" engine: "double", "float" (16-lane single-precision
+    // kernel) or "validate" (both; logs the deviation and keeps the double result)
+    std::string enum_precision = "double";
+    // directory for per-chunk partial sums of the enumeration ("none": not written); a
+    // restarted evaluation of the same model skips the chunks found there
+    std::string scratch_dir = "none";
+
+    // sharded enumeration: process shard_index of shard_count (Full_Shard / Full_Merge)
+    int shard_index = 0;
+    int shard_count = 1;
+
     // model training parameters
     size_t maxIterations   = 1000;
     size_t save_checkpoint = 10000;
@@ -60,6 +90,21 @@ struct RunParameters
     size_t num_samples        = 1000;
     size_t step_correlation   = 100;
     size_t number_repetitions = 20;
+    // heat-bath chains advanced together, vectorized across the chains (8 or 16); 1 runs
+    // them one at a time, which spreads short runs over more threads
+    int hb_lanes = 1;
+    // heat-bath chains the num_samples * number_repetitions samples are split over:
+    // -1 number_repetitions chains of num_samples, 0 one per thread, n > 0 n chains
+    int hb_chains = -1;
+    // keep every chain's final state and generator and continue them in the next call at
+    // the same beta (training iterations), after step_reequilibration sweeps instead of
+    // step_equilibration from all spins -1
+    bool persistent_chains      = false;
+    size_t step_reequilibration = 1000;
+    // equilibrate this many seed chains (0: every chain on its own) and fork the
+    // chains from them, each decorrelating for step_decorrelation sweeps
+    size_t fork_seed_chains   = 0;
+    size_t step_decorrelation = 1000;
     // Wang-Landau
     size_t pre_maxIterations      = 200;
     size_t pre_step_equilibration = 1000;
@@ -76,6 +121,8 @@ struct RunParameters
     // post-processing temperature dependence
     std::vector<double> beta_range = std::vector<double>();
     std::vector<double> T_range    = std::vector<double>();
+    // enumerate the states once and evaluate every beta from the exact energy levels
+    bool tdep_single_pass = false;
 
     RunParameters() = default;
 
@@ -97,6 +144,15 @@ struct RunParameters
         logger->info("[{}] q_val                  {}", caption, q_val);
         logger->info("[{}] beta                   {}", caption, beta);
         logger->info("[{}] energy_bin             {}", caption, energy_bin);
+        logger->info("[{}] full_engine            {}", caption, full_engine);
+        logger->info("[{}] energy_cache           {}", caption, energy_cache);
+        logger->info("[{}] enum_chunk_log2        {}", caption, enum_chunk_log2);
+        logger->info("[{}] enum_precision         {}", caption, enum_precision);
+        if (scratch_dir != "none")
+            logger->info("[{}] scratch_dir            {}", caption, scratch_dir);
+        if (run_type == "Full_Shard" || run_type == "Full_Merge")
+            logger->info("[{}] shard                  {} of {}", caption, shard_index,
+                         shard_count);
 
         logger->info("[{}] maxIterations          {}", caption, maxIterations);
         logger->info("[{}] save_checkpoint          {}", caption, save_checkpoint);
@@ -121,6 +177,17 @@ struct RunParameters
             logger->info("[{}] num_samples             {}", caption, num_samples);
             logger->info("[{}] step_correlation         {}", caption, step_correlation);
             logger->info("[{}] number_repetitions         {}", caption, number_repetitions);
+            logger->info("[{}] hb_lanes                   {}", caption, hb_lanes);
+            logger->info("[{}] hb_chains                  {}", caption, hb_chains);
+            logger->info("[{}] persistent_chains          {}", caption, persistent_chains);
+            if (persistent_chains)
+                logger->info("[{}] step_reequilibration       {}", caption,
+                             step_reequilibration);
+            if (fork_seed_chains > 0)
+            {
+                logger->info("[{}] fork_seed_chains           {}", caption, fork_seed_chains);
+                logger->info("[{}] step_decorrelation         {}", caption, step_decorrelation);
+            }
         }
         if (run_type == "Temperature_Dep")
         {
@@ -128,6 +195,7 @@ struct RunParameters
                          utils::colPrint(arma::Col<double>(beta_range)));
             logger->info("[{}] T_range =    {}", caption,
                          utils::colPrint(arma::Col<double>(T_range)));
+            logger->info("[{}] tdep_single_pass       {}", caption, tdep_single_pass);
         }
         if (run_type == "Wang_Landau")
         {
@@ -168,6 +236,18 @@ struct RunParameters
         obj["q_val"]      = q_val;
         obj["beta"]       = beta;
 
+        obj["full_engine"]     = full_engine;
+        obj["energy_cache"]    = energy_cache;
+        obj["enum_chunk_log2"] = enum_chunk_log2;
+        obj["enum_precision"]  = enum_precision;
+        if (scratch_dir != "none")
+            obj["scratch_dir"] = scratch_dir;
+        if (run_type == "Full_Shard" || run_type == "Full_Merge")
+        {
+            obj["shard_index"] = shard_index;
+            obj["shard_count"] = shard_count;
+        }
+
         tr["maxIterations"]   = maxIterations;
         tr["save_checkpoint"] = save_checkpoint;
         tr["tolerance_h"]     = tolerance_h;
@@ -187,17 +267,24 @@ struct RunParameters
 
         if (run_type == "Heat_Bath" || run_type == "Wang_Landau")
         {
-            mc["rng_seed"]           = rng_seed;
-            mc["step_equilibration"] = step_equilibration;
-            mc["num_samples"]        = num_samples;
-            mc["step_correlation"]   = step_correlation;
-            mc["number_repetitions"] = number_repetitions;
-            obj["Monte_Carlo"]       = mc;
+            mc["rng_seed"]             = rng_seed;
+            mc["step_equilibration"]   = step_equilibration;
+            mc["num_samples"]          = num_samples;
+            mc["step_correlation"]     = step_correlation;
+            mc["number_repetitions"]   = number_repetitions;
+            mc["hb_lanes"]             = hb_lanes;
+            mc["hb_chains"]            = hb_chains;
+            mc["persistent_chains"]    = persistent_chains;
+            mc["step_reequilibration"] = step_reequilibration;
+            mc["fork_seed_chains"]     = fork_seed_chains;
+            mc["step_decorrelation"]   = step_decorrelation;
+            obj["Monte_Carlo"]         = mc;
         }
         if (run_type == "Temperature_Dep")
         {
-            obj["beta_range"] = beta_range;
-            obj["T_range"]    = T_range;
+            obj["beta_range"]       = beta_range;
+            obj["T_range"]          = T_range;
+            obj["tdep_single_pass"] = tdep_single_pass;
         }
 
         if (run_type == "Wang_Landau")
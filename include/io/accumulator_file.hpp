@@ -0,0 +1,154 @@
+#pragma once
+
+#include "trainers/ensemble_accumulator.hpp"
+#include "utils/dense_histogram.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace io
+{
+
+namespace detail
+{
+constexpr char accumulator_magic[8] = {'M', 'X', 'E', 'A', 'C', 'C', '0', '1'};
+
+template <typename T> void write_pod(std::ofstream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool read_pod(std::ifstream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+inline void write_col(std::ofstream &out, const arma::Col<double> &v)
+{
+    write_pod(out, static_cast<uint64_t>(v.n_elem));
+    out.write(reinterpret_cast<const char *>(v.memptr()), v.n_elem * sizeof(double));
+}
+
+inline bool read_col(std::ifstream &in, arma::Col<double> &v)
+{
+    uint64_t n = 0;
+    if (!read_pod(in, n) || n > (uint64_t(1) << 32))
+        return false;
+    v.set_size(n);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(v.memptr()), n * sizeof(double)));
+}
+
+inline void write_histogram(std::ofstream &out, const utils::DenseHistogram<double> &H)
+{
+    write_pod(out, static_cast<uint64_t>(H.size()));
+    for (const auto &[bin, weight] : H)
+    {
+        write_pod(out, static_cast<int32_t>(bin));
+        write_pod(out, weight);
+    }
+}
+
+inline bool read_histogram(std::ifstream &in, utils::DenseHistogram<double> &H)
+{
+    uint64_t n = 0;
+    if (!read_pod(in, n) || n > (uint64_t(1) << 32))
+        return false;
+    std::vector<std::pair<int32_t, double>> bins(n);
+    for (auto &[bin, weight] : bins)
+    {
+        if (!read_pod(in, bin) || !read_pod(in, weight))
+            return false;
+    }
+    // one allocation for the union of the current range and the bins of the file
+    int lo = H.min_bin(), hi = H.max_bin();
+    for (const auto &[bin, weight] : bins)
+    {
+        lo = (hi < lo) ? bin : std::min<int>(lo, bin);
+        hi = std::max<int>(hi, bin);
+    }
+    H.reset(lo, hi);
+    for (const auto &[bin, weight] : bins)
+        H[bin] = weight;
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief Writes an EnsembleAccumulator to a binary file, tagged with a fingerprint of the
+ * evaluation it belongs to.
+ *
+ * The file is written under a temporary name and renamed, so a crash never leaves a
+ * truncated file behind.
+ */
+inline void writeAccumulator(const EnsembleAccumulator &acc,
+                             uint64_t fingerprint,
+                             const std::string &filename)
+{
+    std::string tmp_name = filename + ".tmp";
+    {
+        std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("Could not open accumulator file for writing: " + tmp_name);
+
+        out.write(detail::accumulator_magic, sizeof(detail::accumulator_magic));
+        detail::write_pod(out, fingerprint);
+        detail::write_pod(out, acc.Z);
+        detail::write_pod(out, acc.energy);
+        detail::write_pod(out, acc.energy_sq);
+        detail::write_pod(out, acc.magnetization);
+        detail::write_pod(out, acc.n_states);
+        detail::write_pod(out, acc.n_supp);
+        detail::write_pod(out, acc.max_weight);
+        detail::write_pod(out, acc.max_bracket);
+        detail::write_pod(out, acc.max_weight_energy);
+        detail::write_col(out, acc.m1);
+        detail::write_col(out, acc.m2);
+        detail::write_col(out, acc.m3);
+        detail::write_col(out, acc.pK);
+        detail::write_histogram(out, acc.GE);
+        detail::write_histogram(out, acc.PE);
+        if (!out)
+            throw std::runtime_error("Could not write accumulator file: " + tmp_name);
+    }
+    std::filesystem::rename(tmp_name, filename);
+}
+
+/**
+ * @brief Reads an accumulator written by writeAccumulator.
+ *
+ * @return false if the file is missing, truncated, or belongs to another evaluation
+ *         (different fingerprint); acc is then unspecified.
+ */
+inline bool readAccumulator(const std::string &filename,
+                            uint64_t fingerprint,
+                            EnsembleAccumulator &acc)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[sizeof(detail::accumulator_magic)];
+    uint64_t file_fingerprint = 0;
+    if (!in.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), detail::accumulator_magic) ||
+        !detail::read_pod(in, file_fingerprint) || file_fingerprint != fingerprint)
+        return false;
+
+    return detail::read_pod(in, acc.Z) && detail::read_pod(in, acc.energy) &&
+           detail::read_pod(in, acc.energy_sq) && detail::read_pod(in, acc.magnetization) &&
+           detail::read_pod(in, acc.n_states) && detail::read_pod(in, acc.n_supp) &&
+           detail::read_pod(in, acc.max_weight) && detail::read_pod(in, acc.max_bracket) &&
+           detail::read_pod(in, acc.max_weight_energy) && detail::read_col(in, acc.m1) &&
+           detail::read_col(in, acc.m2) && detail::read_col(in, acc.m3) &&
+           detail::read_col(in, acc.pK) && detail::read_histogram(in, acc.GE) &&
+           detail::read_histogram(in, acc.PE);
+}
+
+} // namespace io
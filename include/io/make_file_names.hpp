@@ -86,6 +86,24 @@ inline std::string make_replica_correlation_filename(const RunParameters &params
     return output.string();
 }
 
+/**
+ * @brief Construct the filename of the partial sums of one shard (Full_Shard / Full_Merge).
+ *
+ * The name is deterministic, so the merge step finds the files of every shard.
+ */
+inline std::string make_shard_filename(const RunParameters &params, int shard_index)
+{
+    std::ostringstream outdir;
+    outdir << params.result_dir << "/shards";
+    utils::make_path(outdir.str());
+
+    std::ostringstream fname;
+    fname << outdir.str() << "/shard_" << params.runid << "_n" << params.nspins << "_"
+          << shard_index << "of" << params.shard_count << ".bin";
+    // example: ./results/shards/shard_$(runid)_n$(nspins)_$(k)of$(K).bin
+    return fname.str();
+}
+
 inline std::string make_DensOfStates_filename(const RunParameters &params)
 {
     std::ostringstream outdir;
@@ -1,20 +1,14 @@
 #pragma once
 
-#include <algorithm>
+#include "utils/dense_histogram.hpp"
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
-#include <vector>
+#include <string>
 
-void write_g_E(const std::unordered_map<int, double> &H,
+void write_g_E(const utils::DenseHistogram<double> &H,
                double bin_width,
                const std::string &filename)
 {
-    // Copy to vector and sort by key (energy bin)
-    std::vector<std::pair<int, double>> sorted_H(H.begin(), H.end());
-    std::sort(sorted_H.begin(), sorted_H.end(),
-              [](const auto &a, const auto &b) { return a.first < b.first; });
-
     // Open file for writing
     std::ofstream file(filename);
     if (!file.is_open())
@@ -26,8 +20,8 @@ void write_g_E(const std::unordered_map<int, double> &H,
     // Write header
     file << "Energy,Weight\n";
 
-    // Write sorted data
-    for (const auto &[bin, weight] : sorted_H)
+    // Write data, sorted by energy bin
+    for (const auto &[bin, weight] : H)
         file << bin * bin_width << "," << weight << "\n";
 
     file.close();
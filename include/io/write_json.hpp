@@ -46,20 +46,14 @@ void writeTrainedModel(const T &model,
         obj["sample"] = "true";
     }
 
-    auto map_ge = model.get_GE();
-    auto map_pe = model.get_PE();
+    // histograms iterate their bins in ascending order
+    const auto &hist_ge = model.get_GE();
+    const auto &hist_pe = model.get_PE();
 
     arma::Col<double> en, we;
     auto wbin = model.get_params().energy_bin;
 
-    std::vector<std::pair<int, double>> sorted_GE(map_ge.begin(), map_ge.end());
-    std::sort(sorted_GE.begin(), sorted_GE.end(),
-              [](const auto &a, const auto &b) { return a.first < b.first; });
-    std::vector<std::pair<int, double>> sorted_PE(map_pe.begin(), map_pe.end());
-    std::sort(sorted_PE.begin(), sorted_PE.end(),
-              [](const auto &a, const auto &b) { return a.first < b.first; });
-
-    for (const auto &[bin, weight] : sorted_GE)
+    for (const auto &[bin, weight] : hist_ge)
     {
         en.insert_rows(en.n_rows, 1);
         en(en.n_rows - 1) = bin * wbin;
@@ -72,7 +66,7 @@ void writeTrainedModel(const T &model,
 
     en.clear();
     we.clear();
-    for (const auto &[bin, weight] : sorted_PE)
+    for (const auto &[bin, weight] : hist_pe)
     {
         en.insert_rows(en.n_rows, 1);
         en(en.n_rows - 1) = bin * wbin;
@@ -83,6 +77,24 @@ void writeTrainedModel(const T &model,
 
     obj["PE"]   = we;
 
+    // magnetization sectors k = 0..nspins, with full_engine "sectors"
+    if constexpr (requires { model.get_sector_Z(); })
+    {
+        const auto &sector_Z = model.get_sector_Z();
+        if (!sector_Z.is_empty())
+        {
+            for (size_t k = 0; k < sector_Z.n_elem; ++k)
+            {
+                nlohmann::json sector;
+                sector["k"]  = k;
+                sector["Z"]  = sector_Z(k);
+                sector["m1"] = arma::Col<double>(model.get_sector_m1().col(k));
+                sector["m2"] = arma::Col<double>(model.get_sector_m2().col(k));
+                obj["sectors"].push_back(sector);
+            }
+        }
+    }
+
     
     
     std::ofstream out(filename);
@@ -4,6 +4,7 @@
 #include "io/read_trained_json.hpp"
 #include "utils/compute_data_statistics.hpp"
 #include "utils/get_logger.hpp"
+#include "utils/spin_state.hpp"
 #include "utils/utilities.hpp"
 #include <armadillo>
 #include <memory>
@@ -198,7 +199,8 @@ class BaseTrainer
     void plawUpdateModel(size_t t);
     void secantUpdateModel(size_t);
 
-    double energyAllPairs(arma::Col<int> s);
+    double energyAllPairs(const utils::SpinState &s) const;
+    const utils::SpinKernels *spin_kernels; // core.kernels(), selected once
 
   private:
     std::string className = "BasicTrainer";
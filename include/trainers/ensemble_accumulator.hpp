@@ -0,0 +1,90 @@
+#pragma once
+
+#include "utils/dense_histogram.hpp"
+#include <armadillo>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Unnormalized sums of a full-ensemble evaluation over a range of states.
+ *
+ * One accumulator covers one chunk (or the states of one thread, shard, ...); accumulators of
+ * disjoint ranges are combined with merge(), and FullEnsembleTrainer::storeAverages divides
+ * by Z at the end. The size does not depend on the number of states, so per-thread memory is
+ * bounded by the moments and the energy histograms.
+ */
+struct EnsembleAccumulator
+{
+    double Z             = 0.0; // sum P
+    double energy        = 0.0; // sum P E
+    double energy_sq     = 0.0; // sum P E^2
+    double magnetization = 0.0; // sum P (2k - n) / n
+    uint64_t n_states    = 0;   // states visited
+    uint64_t n_supp      = 0;   // states with 1 - (1-q) beta E > 0
+
+    double max_weight        = -std::numeric_limits<double>::max(); // largest P
+    double max_bracket       = -std::numeric_limits<double>::max(); // its 1 - (1-q) beta E
+    double max_weight_energy = -std::numeric_limits<double>::max(); // its E
+
+    arma::Col<double> m1; // sum P s_i
+    arma::Col<double> m2; // sum P s_i s_j, i < j
+    arma::Col<double> m3; // sum P s_i s_j s_k, i < j < k (empty without triplets)
+    arma::Col<double> pK; // sum P over the states with k up spins
+
+    utils::DenseHistogram<double> GE; // number of states per energy bin
+    utils::DenseHistogram<double> PE; // sum P per energy bin
+
+    EnsembleAccumulator() = default;
+
+    // max_bin >= 0 sizes the histograms for the energy bins [-max_bin, max_bin]
+    EnsembleAccumulator(int nspins, int nedges, int ntriplets, int max_bin = -1)
+    {
+        m1.zeros(nspins);
+        m2.zeros(nedges);
+        m3.zeros(ntriplets);
+        pK.zeros(nspins + 1);
+        if (max_bin >= 0)
+        {
+            GE.reset(-max_bin, max_bin);
+            PE.reset(-max_bin, max_bin);
+        }
+    }
+
+    // zeroes the sums, keeping the sizes
+    void reset()
+    {
+        Z = energy = energy_sq = magnetization = 0.0;
+        n_states = n_supp = 0;
+        max_weight = max_bracket = max_weight_energy = -std::numeric_limits<double>::max();
+        m1.zeros();
+        m2.zeros();
+        m3.zeros();
+        pK.zeros();
+        GE.clear();
+        PE.clear();
+    }
+
+    // adds the sums of a disjoint range of states
+    void merge(const EnsembleAccumulator &other)
+    {
+        if (other.max_weight > max_weight)
+        {
+            max_weight        = other.max_weight;
+            max_bracket       = other.max_bracket;
+            max_weight_energy = other.max_weight_energy;
+        }
+        Z += other.Z;
+        energy += other.energy;
+        energy_sq += other.energy_sq;
+        magnetization += other.magnetization;
+        n_states += other.n_states;
+        n_supp += other.n_supp;
+
+        m1 += other.m1;
+        m2 += other.m2;
+        m3 += other.m3;
+        pK += other.pK;
+        GE.merge(other.GE);
+        PE.merge(other.PE);
+    }
+};
@@ -1,33 +1,121 @@
 #pragma once
 
 #include "base_trainer.hpp"
+#include "trainers/ensemble_accumulator.hpp"
 #include "core/run_parameters.hpp"
 #include "io/make_file_names.hpp"
 #include "io/write_json.hpp"
 #include "utils/centered_moments.hpp"
+#include "utils/dense_histogram.hpp"
+#include "utils/energy_levels.hpp"
+#include <vector>
 
 class FullEnsembleTrainer : public BaseTrainer
 {
   public:
     FullEnsembleTrainer(MaxEntCore &core, RunParameters &params, const std::string &data_filename) :
-        BaseTrainer(core, params, data_filename) {};
+        BaseTrainer(core, params, data_filename)
+    {
+        enum_single_precision = (this->params.enum_precision == "float");
+    };
+
+    // largest deviation of the float kernel's averages accepted without a warning
+    static constexpr double single_precision_tolerance = 1e-4;
 
     void computeModelAverages(double beta = 1.0, bool triplets = false) override;
     void computeModelAverages1(double beta = 1.0, bool triplets = false);
+    void computeModelAveragesWHT(double beta = 1.0, bool triplets = false);
+    void computeModelAveragesGray(double beta = 1.0, bool triplets = false);
+    void computeModelAveragesBlocked(double beta = 1.0, bool triplets = false);
+    void computeModelAveragesPruned(double beta = 1.0, bool triplets = false);
+    void computeModelAveragesSectors(double beta = 1.0, bool triplets = false);
+    utils::EnergyLevels computeEnergyLevels();
+    double singlePrecisionDeviation(const EnsembleAccumulator &reference,
+                                    const EnsembleAccumulator &single) const;
+    EnsembleAccumulator enumerateChunks(uint64_t first_chunk,
+                                        uint64_t last_chunk,
+                                        double beta,
+                                        bool triplets);
+    uint64_t numberOfChunks() const;
+    void storeAverages(const EnsembleAccumulator &acc, bool triplets);
+    uint64_t enumerationFingerprint(double beta, bool triplets) const;
+    std::string chunkDirectory(double beta, bool triplets) const;
+    void clearEnumerationCheckpoints();
     void train() override;
     void saveModel(std::string filename, bool run_last) const;
-    const std::unordered_map<int, double> &get_GE() const
+    const utils::DenseHistogram<double> &get_GE() const
     {
         return GE;
     }
 
-    const std::unordered_map<int, double> &get_PE() const
+    const utils::DenseHistogram<double> &get_PE() const
     {
         return PE;
     }
 
+    // per-sector statistics of the last "sectors" evaluation (empty for other engines)
+    const arma::Col<double> &get_sector_Z() const
+    {
+        return sector_Z;
+    }
+
+    const arma::Mat<double> &get_sector_m1() const
+    {
+        return sector_m1;
+    }
+
+    const arma::Mat<double> &get_sector_m2() const
+    {
+        return sector_m2;
+    }
+
   private:
     std::string className = "FullEnsembleTrainer";
-    std::unordered_map<int, double> PE; // energy histogram
-    std::unordered_map<int, double> GE; // energy histogram
+    utils::DenseHistogram<double> PE; // energy histogram
+    utils::DenseHistogram<double> GE; // energy histogram
+
+    // magnetization sectors k = 0..nspins (up spins), filled by computeModelAveragesSectors
+    arma::Col<double> sector_Z;  // Z_k: sum of the weights of sector k, not normalized
+    arma::Mat<double> sector_m1; // column k: <s_i | k>
+    arma::Mat<double> sector_m2; // column k: <s_i s_j | k>, i < j
+
+    // pairwise energies -sum h s - sum J s s of all 2^n states (params.energy_cache)
+    std::vector<double> energy_table;
+    std::vector<float> energy_table_f;
+    arma::Col<double> energy_table_h; // h the table corresponds to
+    arma::Col<double> energy_table_J; // J the table corresponds to
+    int energy_table_patches = 0;     // patched updates since the last full rebuild
+
+    void updateEnergyTable();
+
+    // enumerateChunks uses enumerateChunkFloat (params.enum_precision)
+    bool enum_single_precision = false;
+
+    // Enumeration kernels, compiled once per combination of model flags so that the inner
+    // loops carry no tests of them: KTerms (k-pairwise terms K[k] present), Boltzmann (q = 1)
+    // and Triplets (m3 and energy histograms). enumerateChunks picks one per call.
+    using ChunkKernel = void (FullEnsembleTrainer::*)(uint64_t begin,
+                                                      uint64_t end,
+                                                      double beta,
+                                                      EnsembleAccumulator &acc);
+    template <bool KTerms, bool Boltzmann, bool Triplets>
+    void enumerateChunk(uint64_t begin, uint64_t end, double beta, EnsembleAccumulator &acc);
+    template <bool KTerms, bool Boltzmann, bool Triplets>
+    void enumerateChunkFloat(uint64_t begin, uint64_t end, double beta, EnsembleAccumulator &acc);
+    static ChunkKernel chunkKernel(bool k_terms, bool boltzmann, bool triplets);
+    static ChunkKernel chunkKernelFloat(bool k_terms, bool boltzmann, bool triplets);
+    ChunkKernel selectChunkKernel(bool triplets) const;
+
+    // chunk directories kept on disk: the evaluation of the model in the last checkpoint
+    // (the one a resumed run repeats first) and the latest evaluation, until a newer one
+    // finishes
+    std::string checkpoint_chunk_dir;
+    std::string last_chunk_dir;
+    bool next_dir_is_checkpoint = true; // the next evaluation is of the checkpointed model
+    void retireChunkDirectory(const std::string &chunk_dir);
+
+    double tableEnergy(size_t x) const
+    {
+        return energy_table_f.empty() ? energy_table[x] : static_cast<double>(energy_table_f[x]);
+    }
 };
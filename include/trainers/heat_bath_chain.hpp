@@ -0,0 +1,119 @@
+#pragma once
+
+#include "core/max_ent_core.hpp"
+#include "utils/philox.hpp"
+#include "utils/spin_kernels.hpp"
+#include "utils/spin_state.hpp"
+#include "utils/vector_math.hpp"
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief One heat-bath chain: the spins, their generator, and the local fields
+ * f_i = h_i + sum_j J_ij s_j, pairwise energy and number of up spins, which follow every
+ * flip.
+ *
+ * start() evaluates the fields, energy and k of a state once; a sweep then updates them
+ * incrementally: keeping s_i costs O(1), a flip changes the energy by -delta f_i and every
+ * other field by delta J_ij (a row of core.J_dense), with delta = s_i' - s_i. One object
+ * per thread is reused for all its chains, so the sweeps do not allocate.
+ *
+ * Every sweep draws exactly one uniform per spin from the chain's Philox stream, so the
+ * number that decides spin i in sweep t (counting the equilibration) is uniform
+ * t * nspins + i of the stream, whichever thread runs the chain.
+ *
+ * @tparam N          Number of spins if specialized (utils/spin_kernels.hpp), 0 otherwise.
+ * @tparam KPairwise  Updates include the K[k] terms (params.k_pairwise).
+ */
+template <int N, bool KPairwise> class HeatBathChain
+{
+  public:
+    HeatBathChain(const MaxEntCore &core, double beta) :
+        s(N > 0 ? N : core.nspins), core(core), beta(beta), nspins(s.size()), field(nspins),
+        logit_r(nspins)
+    {
+    }
+
+    void start(const utils::SpinState &state, const utils::Philox &generator)
+    {
+        s   = state;
+        rng = generator;
+        for (int i = 0; i < nspins; ++i)
+            field[i] = utils::denseField<N>(core.h(i), core.J_dense.row(i), s.data(), nspins);
+        E_pairs = utils::pairEnergy<N>(core.h.memptr(), core.J.memptr(), s.data(), nspins);
+        ki      = s.numUp();
+    }
+
+    void sweep()
+    {
+        drawLogits();
+        for (int i = 0; i < nspins; ++i)
+        {
+            const double h_i = field[i];
+            int s_new;
+            if constexpr (KPairwise)
+            {
+                // P(s_i = +1) / P(s_i = -1) = exp(beta (2 f_i + K[k_plus] - K[k_minus])), with
+                // k_plus and k_minus the up spins of the state with s_i = +1 and s_i = -1
+                const auto &K      = core.K;
+                const int k_plus   = ki + (s(i) == -1);
+                const int k_minus  = ki - (s(i) == 1);
+                const double logit = 2.0 * h_i + K(k_plus) - K(k_minus);
+                double prob_plus   = 1.0 / (1.0 + std::exp(-beta * logit));
+                double r           = rng.uniform();
+                s_new              = (r < prob_plus) ? 1 : -1;
+            }
+            else
+            {
+                s_new = (2.0 * beta * h_i > logit_r[i]) ? 1 : -1;
+            }
+
+            if (s_new != s(i))
+            {
+                const double delta = 2.0 * s_new;
+                s.flip(i);
+                E_pairs -= delta * h_i;
+                ki += s_new;
+                utils::updateDenseFields<N>(delta, core.J_dense.row(i), field.data(), nspins);
+            }
+        }
+    }
+
+    // the energy -sum h_i s_i - sum J_ij s_i s_j - K[k] of the current state
+    double energy() const
+    {
+        return E_pairs - core.K(ki);
+    }
+
+    // the local fields f_i of the current state
+    const std::vector<double> &fields() const
+    {
+        return field;
+    }
+
+    utils::SpinState s;
+    utils::Philox rng;
+    double E_pairs = 0.0; // energy without the K[k] term
+    int ki         = 0;   // up spins
+
+  private:
+    const MaxEntCore &core;
+    const double beta;
+    const int nspins;
+    std::vector<double> field;
+    std::vector<double> logit_r;
+
+    // Without k-pairwise, r < 1 / (1 + exp(-2 beta h_i)) <=> 2 beta h_i > log(r / (1-r)).
+    // The fields depend on the spins updated before, but the uniforms do not: a sweep draws
+    // them up front (in the same order, one batch of Philox blocks) and takes all their
+    // logits in one vectorized call instead of one exp per spin.
+    void drawLogits()
+    {
+        if constexpr (KPairwise)
+            return;
+        rng.uniforms(logit_r.data(), nspins);
+        for (int i = 0; i < nspins; ++i)
+            logit_r[i] = logit_r[i] / (1.0 - logit_r[i]);
+        utils::log_q_batch(logit_r.data(), logit_r.data(), nspins, 1.0);
+    }
+};
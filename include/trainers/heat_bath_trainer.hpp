@@ -5,6 +5,12 @@
 #include "io/make_file_names.hpp"
 #include "io/write_json.hpp"
 #include "utils/centered_moments.hpp"
+#include "utils/dense_histogram.hpp"
+#include "utils/packed_replicas.hpp"
+#include "utils/philox.hpp"
+#include "utils/spin_state.hpp"
+#include <limits>
+#include <vector>
 
 class HeatBathTrainer : public BaseTrainer
 {
@@ -20,8 +26,8 @@ class HeatBathTrainer : public BaseTrainer
         total_number_samples = params.num_samples * params.number_repetitions;
 
         int nspins = core.nspins;
-        replicas.set_size(total_number_samples, nspins);
-        replicas.fill(-1);
+        replicas.resize(total_number_samples, nspins);
+        scheduleChains();
     }
 
     void computeModelAverages(double beta = 1.0, bool triplets = false) override;
@@ -31,26 +37,75 @@ class HeatBathTrainer : public BaseTrainer
 
     void saveModel(std::string filename) const;
 
-    const arma::Mat<int> &get_replicas() const
+    // the recorded states, bit-packed (a view of the trainer's storage)
+    utils::ReplicaView get_replicas() const
     {
-        return replicas;
+        return replicas.view();
     }
-    const std::unordered_map<int, double> &get_GE() const
+    const utils::DenseHistogram<double> &get_GE() const
     {
         return GE;
     }
 
-        const std::unordered_map<int, double> &get_PE() const
+        const utils::DenseHistogram<double> &get_PE() const
     {
         return PE;
     }
+
+    // mean overlap of the first samples of chains forked from the same seed, and the overlap
+    // (1/n) sum_i <s_i>^2 of independent samples (NaN until chains are forked)
+    double get_fork_overlap() const
+    {
+        return fork_overlap;
+    }
+    double get_independent_overlap() const
+    {
+        return independent_overlap;
+    }
+    // standard error of get_fork_overlap(), counted per chain (NaN until chains are forked)
+    double get_fork_overlap_error() const
+    {
+        return fork_overlap_error;
+    }
   private:
     std::string className = "FullEnsembleTrainer";
     int mc_seed           = 1;
 
     size_t total_number_samples; // Total number of samples
-    arma::Mat<int> replicas;
+    utils::PackedReplicas replicas;
+
+    // The samples are split over the chains (params.hb_chains): chain n collects
+    // chain_samples[n] of them into the replica rows from chain_offsets[n].
+    std::vector<size_t> chain_samples;
+    std::vector<size_t> chain_offsets;
+    void scheduleChains();
+
+    // Where the chains of a call start (prepareChains): new chains from all spins -1 with the
+    // generators utils::Philox(mc_seed, n), or the states and generators of chain_states and
+    // chain_rngs, which hold the persistent chains (params.persistent_chains, continued at
+    // the same beta) or the chains forked from equilibrated seeds (params.fork_seed_chains).
+    std::vector<utils::SpinState> chain_states;
+    std::vector<utils::Philox> chain_rngs;
+    double chain_beta      = 0.0;   // beta of the persistent chains
+    bool stored_chains     = false; // this call starts from chain_states
+    bool forked_chains     = false; // ... which were forked from seed chains
+    size_t n_equilibration = 0;     // sweeps before the first sample
+    void prepareChains(double beta);
+    template <int N, bool KPairwise> void forkChains(double beta);
+
+    // forked chains: the first sample of every chain and how far siblings decorrelated
+    std::vector<utils::SpinState> fork_states;
+    double fork_overlap        = std::numeric_limits<double>::quiet_NaN();
+    double fork_overlap_error  = std::numeric_limits<double>::quiet_NaN();
+    double independent_overlap = std::numeric_limits<double>::quiet_NaN();
+    void measureForkOverlap();
+
+    // computeModelAverages picks the instantiation for nspins, params.k_pairwise and triplets
+    using SamplingKernel = void (HeatBathTrainer::*)(double beta);
+    template <int N, bool KPairwise, bool Triplets> void sampleModelAverages(double beta);
+    // params.hb_lanes chains at a time, vectorized across the chains
+    template <int Lanes, bool KPairwise, bool Triplets> void sampleReplicaLanes(double beta);
 
-    std::unordered_map<int, double> PE; // energy histogram
-    std::unordered_map<int, double> GE; // energy histogram
+    utils::DenseHistogram<double> PE; // energy histogram
+    utils::DenseHistogram<double> GE; // energy histogram
 };
\ No newline at end of file
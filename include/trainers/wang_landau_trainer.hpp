@@ -4,6 +4,9 @@
 #include "io/make_file_names.hpp"
 #include "io/write_json.hpp"
 #include "utils/centered_moments.hpp"
+#include "utils/dense_histogram.hpp"
+#include "utils/packed_replicas.hpp"
+#include "utils/philox.hpp"
 
 #include <armadillo>
 #include <random>
@@ -28,8 +31,7 @@ class WangLandauTrainer : public BaseTrainer
         total_number_samples = params.num_samples * params.number_repetitions;
         
         int nspins = core.nspins;
-        replicas.set_size(total_number_samples, nspins);
-        replicas.fill(-1);
+        replicas.resize(total_number_samples, nspins);
     }
 
     void computeModelAverages(double beta=1.0, bool triplets=false) override;
@@ -38,24 +40,25 @@ class WangLandauTrainer : public BaseTrainer
     void saveModel(std::string prefix) const;
 
 
-    const arma::Mat<int> &get_replicas() const
+    // the recorded states, bit-packed (a view of the trainer's storage)
+    utils::ReplicaView get_replicas() const
     {
-        return replicas;
+        return replicas.view();
     }
 
-    const std::unordered_map<int, double> &get_log_g_E() const
+    const utils::DenseHistogram<double> &get_log_g_E() const
     {
         return log_g_E;
     }
     
     void computeDensityOfStates();
 
-    const std::unordered_map<int, double> &get_GE() const
+    const utils::DenseHistogram<double> &get_GE() const
     {
         return GE;
     }
 
-        const std::unordered_map<int, double> &get_PE() const
+        const utils::DenseHistogram<double> &get_PE() const
     {
         return PE;
     }
@@ -65,16 +68,17 @@ class WangLandauTrainer : public BaseTrainer
     int wg_seed           = 1;
 
     size_t total_number_samples; // Total number of samples
-    arma::Mat<int> replicas;
+    utils::PackedReplicas replicas;
 
-    std::unordered_map<int, double> log_g_E; // ln(G(E) density of states
-    std::unordered_map<int, int> H;          // energy histogram
+    utils::DenseHistogram<double> log_g_E; // ln(G(E) density of states
+    utils::DenseHistogram<int> H;          // energy histogram
 
-    std::unordered_map<int, double> PE; // energy histogram
-    std::unordered_map<int, double> GE; // energy histogram
-    void flip_random_spin(arma::Col<int> &s, std::mt19937 &rng);
+    utils::DenseHistogram<double> PE; // energy histogram
+    utils::DenseHistogram<double> GE; // energy histogram
+    int flip_random_spin(utils::SpinState &s, utils::Philox &rng);
+    double flippedEnergy(const utils::SpinState &s, int i, double E) const;
 
-    bool is_flat(const std::unordered_map<int, int> &H, 
+    bool is_flat(const utils::DenseHistogram<int> &H, 
                  double flatness_threshold = 0.8);
 
 
@@ -1,25 +1,27 @@
 #pragma once
 
-#include <armadillo>
+#include "utils/spin_state.hpp"
+#include <cstdint>
 #include <iterator>
 
 class BinaryPermutationsIterator {
 public:
-    using value_type = arma::Col<int>;
+    using value_type = utils::SpinState;
     using iterator_category = std::input_iterator_tag;
     using difference_type = std::ptrdiff_t;
     using pointer = const value_type*;
     using reference = const value_type&;
 
-    BinaryPermutationsIterator(int n, int start_index, int end_index, bool end = false)
+    BinaryPermutationsIterator(int n, uint64_t start_index, uint64_t end_index, bool end = false)
         : n(n), current_index(end ? end_index : start_index), end_index(end_index), finished(end) {
         if (!finished) {
-            current_permutation = arma::Col<int>(n, arma::fill::zeros);
+            current_permutation = utils::SpinState(n);
             updateCurrentPermutation();
         }
     }
 
-    value_type operator*() const {
+    // the state is updated in place: the reference is valid until the next increment
+    reference operator*() const {
         return current_permutation;
     }
 
@@ -39,22 +41,20 @@ public:
 
 private:
     void updateCurrentPermutation() {
-        for (int i = 0; i < n; ++i) {
-            current_permutation[i] = (current_index & (1 << (n - i - 1))) ? -1 : +1;
-        }
+        current_permutation.assign(current_index);
     }
 
     int n;
-    int current_index;
-    int end_index;
+    uint64_t current_index; // 64-bit: n up to 63 spins
+    uint64_t end_index;
     bool finished;
-    arma::Col<int> current_permutation;
+    utils::SpinState current_permutation;
 };
 
 class BinaryPermutationsSequence {
 public:
-    BinaryPermutationsSequence(int n, int start = 0, int end = -1)
-        : n(n), start_index(start), end_index(end == -1 ? (1 << n) : end) {}
+    BinaryPermutationsSequence(int n, uint64_t start = 0, int64_t end = -1)
+        : n(n), start_index(start), end_index(end < 0 ? (uint64_t(1) << n) : uint64_t(end)) {}
 
     BinaryPermutationsIterator begin() const {
         return BinaryPermutationsIterator(n, start_index, end_index);
@@ -66,6 +66,6 @@ public:
 
 private:
     int n;
-    int start_index;
-    int end_index;
+    uint64_t start_index;
+    uint64_t end_index;
 };
@@ -1,12 +1,43 @@
 #pragma once
 
+#include "utils/dense_histogram.hpp"
+#include "utils/packed_replicas.hpp"
 #include <algorithm>
 #include <armadillo>
+#include <cstddef>
 #include <iostream>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+/**
+ * @brief Bin centers q = bin delta / n and densities of a histogram of dot products of
+ * n-component vectors, normalized so that sum P(q) delta / n = 1.
+ */
+inline std::pair<std::vector<double>, std::vector<double>> normalized_correlation_histogram(
+    utils::DenseHistogram<double> &raw_hist,
+    const double delta,
+    const std::size_t n)
+{
+    // Compute total area for normalization
+    double total_area = 0.0;
+    for (const auto &[bin, count] : raw_hist)
+        total_area += count * delta / n;
+
+    // Normalize the histogram
+    raw_hist.scale(1.0 / total_area);
+
+    // Extract sorted vectors
+    std::vector<double> bin_centers;
+    std::vector<double> normalized_counts;
+    for (const auto &[bin, count] : raw_hist)
+    {
+        bin_centers.push_back(static_cast<double>(bin) * delta / n);
+        normalized_counts.push_back(count);
+    }
+
+    return {bin_centers, normalized_counts};
+}
+
 /**
  * @brief Computes the normalized histogram of pairwise correlations between rows or columns of a
  * matrix.
@@ -39,8 +70,9 @@ inline std::pair<std::vector<double>, std::vector<double>> correlation_histogram
     const arma::uword dim1 = by_row ? M.n_rows : M.n_cols;
     const arma::uword dim2 = by_row ? M.n_cols : M.n_rows;
 
-    // Build histogram
-    std::unordered_map<int, double> raw_hist;
+    // Build histogram: for entries +-1 the dot products lie in [-dim2, dim2]
+    const int max_bin = static_cast<int>(dim2 / delta) + 1;
+    utils::DenseHistogram<double> raw_hist(-max_bin, max_bin);
     for (arma::uword i = 0; i < dim1; ++i)
     {
         for (arma::uword j = i + 1; j < dim1; ++j)
@@ -60,45 +92,22 @@ inline std::pair<std::vector<double>, std::vector<double>> correlation_histogram
         }
     }
 
-    // Compute total area for normalization
-    double total_area = 0.0;
-    for (const auto &[bin, count] : raw_hist)
-    {
-        if (by_row)
-        total_area += count * delta/M.n_cols;
-        else
-        total_area += count * delta/M.n_rows;
-    }
-
-    // Normalize the histogram
-    for (auto &[bin, count] : raw_hist)
-    {
-        count /= total_area;
-    }
-
-    // Extract sorted vectors
-    std::vector<int> bin_keys;
-    for (const auto &[bin, _] : raw_hist)
-    {
-        bin_keys.push_back(bin);
-    }
-    std::sort(bin_keys.begin(), bin_keys.end());
+    return normalized_correlation_histogram(raw_hist, delta, dim2);
+}
 
-    std::vector<double> bin_centers;
-    std::vector<double> normalized_counts;
-    for (int bin : bin_keys)
-    {
-        if (by_row)
-        {
-            bin_centers.push_back(static_cast<double>(bin) * delta / M.n_cols);
-        }
-        else
-        {
-            bin_centers.push_back(static_cast<double>(bin) * delta / M.n_rows);
-        }
-        // bin_centers.push_back(static_cast<double>(bin) * delta);
-        normalized_counts.push_back(raw_hist[bin]);
-    }
+/**
+ * @brief correlation_histogram over the rows of bit-packed replicas: each dot product is an
+ * overlap from popcounts (utils::ReplicaView::overlap), without unpacking the spins.
+ */
+inline std::pair<std::vector<double>, std::vector<double>> correlation_histogram(
+    const utils::ReplicaView &R,
+    const double delta = 2.0)
+{
+    const int max_bin = static_cast<int>(R.n_spins() / delta) + 1;
+    utils::DenseHistogram<double> raw_hist(-max_bin, max_bin);
+    for (std::size_t i = 0; i < R.n_rows(); ++i)
+        for (std::size_t j = i + 1; j < R.n_rows(); ++j)
+            raw_hist[static_cast<int>(R.overlap(i, j) / delta)] += 1.0;
 
-    return {bin_centers, normalized_counts};
+    return normalized_correlation_histogram(raw_hist, delta, R.n_spins());
 }
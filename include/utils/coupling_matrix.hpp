@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace utils
+{
+
+// std::allocator with the storage aligned to Alignment bytes
+template <typename T, size_t Alignment> struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U> struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment> &)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment> &) const
+    {
+        return true;
+    }
+};
+
+/**
+ * @brief Dense symmetric n x n coupling matrix with a zero diagonal.
+ *
+ * MaxEntCore::J packs the upper triangle, so the couplings of spin i are scattered and
+ * reached through MaxEntCore::edges. Here row i holds J_ij for every j, contiguous and with
+ * each row starting on a cache line (rows are padded with zeros to a multiple of 64 bytes),
+ * so the local field h_i + sum_j J_ij s_j is one dot product.
+ */
+template <typename T> class CouplingMatrix
+{
+  public:
+    static constexpr size_t alignment = 64;
+
+    // zero couplings between n spins
+    void resize(int n_spins)
+    {
+        n      = n_spins;
+        stride = static_cast<int>((n * sizeof(T) + alignment - 1) / alignment * alignment /
+                                  sizeof(T));
+        values.assign(static_cast<size_t>(n) * stride, T(0));
+    }
+
+    void set(int i, int j, double J_ij)
+    {
+        values[static_cast<size_t>(i) * stride + j] = static_cast<T>(J_ij);
+        values[static_cast<size_t>(j) * stride + i] = static_cast<T>(J_ij);
+    }
+
+    // J_ij for j = 0..n-1 (J_ii = 0)
+    const T *row(int i) const
+    {
+        return values.data() + static_cast<size_t>(i) * stride;
+    }
+
+    int size() const
+    {
+        return n;
+    }
+
+  private:
+    int n      = 0;
+    int stride = 0; // elements per row, n rounded up to whole cache lines
+    std::vector<T, AlignedAllocator<T, alignment>> values;
+};
+
+} // namespace utils
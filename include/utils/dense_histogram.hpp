@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * @brief Histogram over a contiguous range of integer bins, stored as a flat array.
+ *
+ * Replaces std::unordered_map<int, T> for energy and correlation histograms: the bin range is
+ * known up front (|E| <= sum |h| + sum |J| + max |K|), so every update is an array access and
+ * merging two histograms is an element-wise add. Like the map, a bin is "present" once it has
+ * been touched, even if its value is zero, and iteration visits the present bins only, in
+ * ascending order. A bin outside the range grows the range instead of failing.
+ */
+template <typename T> class DenseHistogram
+{
+  public:
+    DenseHistogram() = default;
+
+    // empty histogram over the bins [min_bin, max_bin]
+    DenseHistogram(int min_bin, int max_bin)
+    {
+        reset(min_bin, max_bin);
+    }
+
+    // sets the bin range and removes all bins
+    void reset(int min_bin, int max_bin)
+    {
+        offset = min_bin;
+        values.assign(static_cast<size_t>(std::max(max_bin - min_bin + 1, 0)), T(0));
+        present.assign(values.size(), 0);
+    }
+
+    // removes all bins, keeping the range
+    void clear()
+    {
+        std::fill(values.begin(), values.end(), T(0));
+        std::fill(present.begin(), present.end(), uint8_t(0));
+    }
+
+    // value of a bin, marking it present (as std::unordered_map::operator[])
+    T &operator[](int bin)
+    {
+        if (bin < offset || bin >= offset + static_cast<int>(values.size())) [[unlikely]]
+            grow(bin, bin);
+        size_t i   = static_cast<size_t>(bin - offset);
+        present[i] = 1;
+        return values[i];
+    }
+
+    bool contains(int bin) const
+    {
+        return bin >= offset && bin < offset + static_cast<int>(values.size()) &&
+               present[static_cast<size_t>(bin - offset)];
+    }
+
+    // value of a present bin; zero for any other bin
+    T at(int bin) const
+    {
+        return contains(bin) ? values[static_cast<size_t>(bin - offset)] : T(0);
+    }
+
+    // number of present bins
+    size_t size() const
+    {
+        return static_cast<size_t>(std::count(present.begin(), present.end(), uint8_t(1)));
+    }
+
+    bool empty() const
+    {
+        return std::find(present.begin(), present.end(), uint8_t(1)) == present.end();
+    }
+
+    int min_bin() const
+    {
+        return offset;
+    }
+
+    int max_bin() const
+    {
+        return offset + static_cast<int>(values.size()) - 1;
+    }
+
+    // adds the bins of another histogram; with equal ranges this is one vectorized pass
+    void merge(const DenseHistogram &other)
+    {
+        if (other.values.empty())
+            return;
+        if (other.offset != offset || other.values.size() != values.size())
+            grow(other.min_bin(), other.max_bin());
+
+        const size_t shift = static_cast<size_t>(other.offset - offset);
+        const size_t n     = other.values.size();
+        T *v               = values.data() + shift;
+        uint8_t *p         = present.data() + shift;
+        const T *ov        = other.values.data();
+        const uint8_t *op  = other.present.data();
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i)
+        {
+            v[i] += ov[i];
+            p[i] |= op[i];
+        }
+    }
+
+    // multiplies every bin by factor
+    void scale(T factor)
+    {
+        for (auto &v : values)
+            v *= factor;
+    }
+
+    class const_iterator
+    {
+      public:
+        const_iterator(const DenseHistogram *hist, size_t i) : hist(hist), i(i)
+        {
+            skip();
+        }
+
+        std::pair<int, T> operator*() const
+        {
+            return {hist->offset + static_cast<int>(i), hist->values[i]};
+        }
+
+        const_iterator &operator++()
+        {
+            ++i;
+            skip();
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const
+        {
+            return i == other.i;
+        }
+
+        bool operator!=(const const_iterator &other) const
+        {
+            return i != other.i;
+        }
+
+      private:
+        void skip()
+        {
+            while (i < hist->present.size() && !hist->present[i])
+                ++i;
+        }
+
+        const DenseHistogram *hist;
+        size_t i;
+    };
+
+    // present bins as (bin, value) pairs, in ascending bin order
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, values.size());
+    }
+
+  private:
+    // extends the range to cover [lo, hi], keeping the bins
+    void grow(int lo, int hi)
+    {
+        if (values.empty())
+        {
+            reset(lo, hi);
+            return;
+        }
+        int new_min = std::min(lo, offset);
+        int new_max = std::max(hi, max_bin());
+        std::vector<T> new_values(static_cast<size_t>(new_max - new_min + 1), T(0));
+        std::vector<uint8_t> new_present(new_values.size(), 0);
+        std::copy(values.begin(), values.end(), new_values.begin() + (offset - new_min));
+        std::copy(present.begin(), present.end(), new_present.begin() + (offset - new_min));
+        values.swap(new_values);
+        present.swap(new_present);
+        offset = new_min;
+    }
+
+    int offset = 0;               // bin of values[0]
+    std::vector<T> values;        // value per bin
+    std::vector<uint8_t> present; // 1 once a bin has been touched
+};
+
+} // namespace utils
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "utils/utilities.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * @brief Exact energy-resolved summary of all 2^n states of a model.
+ *
+ * Every distinct energy E appears once, with the number of states g(E) at that energy and
+ * the summed magnetization of those states. Any function of the energy alone (and the
+ * magnetization, linearly) can then be averaged at any beta and q without re-enumerating.
+ */
+struct EnergyLevels
+{
+    std::vector<double> energy;        // distinct energies, ascending
+    std::vector<double> degeneracy;    // g(E): number of states with energy E
+    std::vector<double> magnetization; // sum of (2k - n) / n over the states with energy E
+    double n_states = 0.0;             // sum of g(E) = 2^n
+};
+
+/**
+ * @brief Scalar averages of the full ensemble at one (beta, q), as in computeModelAverages.
+ */
+struct ThermalAverages
+{
+    double energy            = 0.0; // <E>
+    double energy_sq         = 0.0; // <E^2>
+    double magnetization     = 0.0; // <M>
+    double f_supp            = 0.0; // fraction of states with 1 - (1-q) beta E > 0
+    double max_weight        = 0.0; // largest P(s) / Z
+    double max_bracket       = 0.0; // 1 - (1-q) beta E of that state
+    double max_weight_energy = 0.0; // E of that state
+};
+
+/**
+ * @brief Averages over the energy levels with weights g(E) exp_q(-beta E).
+ *
+ * For q = 1 the weights are taken relative to the lowest energy, which leaves every
+ * normalized average unchanged and avoids overflow at large beta.
+ */
+inline ThermalAverages thermalAverages(const EnergyLevels &levels, double beta, double q)
+{
+    ThermalAverages res;
+
+    const double one_minus_q = 1.0 - q;
+    const double E_ref       = (q == 1.0 && !levels.energy.empty()) ? levels.energy.front() : 0.0;
+
+    double Z      = 0.0;
+    double n_supp = 0.0;
+    double max_P  = -std::numeric_limits<double>::max();
+    for (size_t l = 0; l < levels.energy.size(); ++l)
+    {
+        double E       = levels.energy[l];
+        double g       = levels.degeneracy[l];
+        double P       = exp_q(-beta * (E - E_ref), q);
+        double bracket = 1.0 - one_minus_q * beta * E;
+        if (P > max_P)
+        {
+            max_P                 = P;
+            res.max_bracket       = bracket;
+            res.max_weight_energy = E;
+        }
+        if (bracket > 0.0)
+            n_supp += g;
+
+        Z += g * P;
+        res.energy += g * P * E;
+        res.energy_sq += g * P * E * E;
+        res.magnetization += P * levels.magnetization[l];
+    }
+
+    res.energy /= Z;
+    res.energy_sq /= Z;
+    res.magnetization /= Z;
+    res.max_weight = max_P / Z;
+    res.f_supp     = n_supp / levels.n_states;
+    return res;
+}
+
+} // namespace utils
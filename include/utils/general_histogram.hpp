@@ -1,7 +1,7 @@
 #pragma once
 
+#include "utils/dense_histogram.hpp"
 #include <armadillo>
-#include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include <iostream>
@@ -12,8 +12,10 @@ template <typename T>
 inline std::pair<std::vector<double>, std::vector<double>>
 compute_histogram(const arma::Mat<T>& M, const double delta)
 {
-    // Build histogram
-    std::unordered_map<int, double> raw_hist;
+    // Build histogram over the bins of the smallest and largest entries
+    utils::DenseHistogram<double> raw_hist;
+    if (!M.is_empty())
+        raw_hist.reset(static_cast<int>(M.min() / delta), static_cast<int>(M.max() / delta));
     for (arma::uword i = 0; i < M.n_rows; ++i) {
         for (arma::uword j = 0; j < M.n_cols; ++j) {
             int bin = static_cast<int>(M(i,j) / delta);
@@ -28,22 +30,14 @@ compute_histogram(const arma::Mat<T>& M, const double delta)
     }
 
     // Normalize the histogram
-    for (auto& [bin, count] : raw_hist) {
-        count /= total_area;
-    }
+    raw_hist.scale(1.0 / total_area);
 
     // Extract sorted vectors
-    std::vector<int> bin_keys;
-    for (const auto& [bin, _] : raw_hist) {
-        bin_keys.push_back(bin);
-    }
-    std::sort(bin_keys.begin(), bin_keys.end());
-
     std::vector<double> bin_centers;
     std::vector<double> normalized_counts;
-    for (int bin : bin_keys) {
+    for (const auto& [bin, count] : raw_hist) {
         bin_centers.push_back(static_cast<double>(bin) * delta);
-        normalized_counts.push_back(raw_hist[bin]);
+        normalized_counts.push_back(count);
     }
 
     return {bin_centers, normalized_counts};
@@ -1,32 +1,51 @@
+#pragma once
+
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <vector>
 
-class GrayCodeIterator 
+/**
+ * Walks spin states in reflected Gray-code order: consecutive states differ by one spin.
+ * The state is updated in place, so dereferencing is O(1) and incrementing flips one entry.
+ * Position k in the sequence is the state gray(k) = k ^ (k >> 1), with bit (n-1-i) set
+ * meaning s_i = -1 (same convention as BinaryPermutationsSequence).
+ */
+class GrayCodeIterator
 {
 public:
     using value_type = std::pair<std::vector<int>, int>; // State and flipped index
 
-    GrayCodeIterator(int n, bool end = false)
-        : n(n), k(end ? (1 << n) : 0), finished(end), last_flipped_index(-1) {}
-
-    value_type operator*() const {
-        std::vector<int> spin_config(n);
-        int gray_code = k ^ (k >> 1);
+    GrayCodeIterator(int n, uint64_t start_index, uint64_t end_index, bool end = false)
+        : n(n), k(end ? end_index : start_index), end_index(end_index),
+          finished(end || start_index >= end_index)
+    {
+        current.first.resize(n);
+        current.second     = -1; // no spin flipped yet
+        uint64_t gray_code = k ^ (k >> 1);
         for (int i = 0; i < n; ++i) {
             int bit = (gray_code >> (n - 1 - i)) & 1;
-            spin_config[i] = spin_values[bit];
+            current.first[i] = spin_values[bit];
         }
-        return {spin_config, last_flipped_index};
+    }
+
+    GrayCodeIterator(int n, bool end = false) : GrayCodeIterator(n, 0, uint64_t(1) << n, end) {}
+
+    const value_type &operator*() const {
+        return current;
     }
 
     GrayCodeIterator& operator++() {
-        int new_k = k + 1;
-        int flipped_bit = __builtin_ctz(k ^ new_k); // Find the position of the flipped bit
-        last_flipped_index = n - 1 - flipped_bit;   // Map to the corresponding index in the spin vector
-        k = new_k;
-        finished = (k >= (1 << n));
+        uint64_t new_k = k + 1;
+        k         = new_k;
+        finished  = (k >= end_index);
+        if (!finished) {
+            int flipped_bit = __builtin_ctzll(new_k); // gray(k-1) ^ gray(k) = 1 << ctz(k)
+            int i           = n - 1 - flipped_bit;    // corresponding index in the spin vector
+            current.first[i] = -current.first[i];
+            current.second   = i;
+        }
         return *this;
     }
 
@@ -34,26 +53,35 @@ public:
         return finished != other.finished;
     }
 
+    // position in the Gray-code sequence
+    uint64_t index() const {
+        return k;
+    }
+
 private:
     int n;                 // Number of spins
-    int k;                 // Current index in the Gray code sequence
+    uint64_t k;            // Current index in the Gray code sequence
+    uint64_t end_index;    // One past the last index of this (sub)sequence
     bool finished;         // Indicates whether the sequence has finished
-    int last_flipped_index; // The index of the bit flipped in the current step
-    const std::vector<int> spin_values = {+1, -1}; // Spin values to use
+    value_type current;    // Current spin state and the index flipped to reach it
+    static constexpr int spin_values[2] = {+1, -1}; // Spin values to use
 };
 
 class GrayCodeSequence {
 public:
-    GrayCodeSequence(int n) : n(n) {}
+    GrayCodeSequence(int n, uint64_t start = 0, int64_t end = -1)
+        : n(n), start_index(start), end_index(end < 0 ? (uint64_t(1) << n) : uint64_t(end)) {}
 
     GrayCodeIterator begin() const {
-        return GrayCodeIterator(n);
+        return GrayCodeIterator(n, start_index, end_index);
     }
 
     GrayCodeIterator end() const {
-        return GrayCodeIterator(n, true);
+        return GrayCodeIterator(n, start_index, end_index, true);
     }
 
 private:
     int n;
+    uint64_t start_index;
+    uint64_t end_index;
 };
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "utils/spin_state.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+
+/**
+ * @brief Read-only view of sampled spin configurations stored one bit per spin.
+ *
+ * Row r occupies words_per_row whole 64-bit words in the layout of SpinState::packed(): spin
+ * i at bit (n-1-i), set <=> s_i = -1. The overlap of two rows is then n - 2 popcount(a ^ b),
+ * a few instructions per 64 spins instead of a dot product of ints. A view is a pointer and
+ * three sizes: consumers take it by value, nothing is copied.
+ */
+class ReplicaView
+{
+  public:
+    ReplicaView() = default;
+    ReplicaView(const uint64_t *words, std::size_t rows, int nspins) :
+        words(words), rows(rows), nspins(nspins), words_per_row(SpinState::packedWords(nspins))
+    {
+    }
+
+    std::size_t n_rows() const
+    {
+        return rows;
+    }
+    int n_spins() const
+    {
+        return nspins;
+    }
+
+    // s_i of row r, +-1
+    int operator()(std::size_t r, int i) const
+    {
+        const int b = nspins - 1 - i;
+        return ((row_words(r)[b / 64] >> (b % 64)) & 1) ? -1 : 1;
+    }
+
+    const uint64_t *row_words(std::size_t r) const
+    {
+        return words + r * words_per_row;
+    }
+
+    SpinState row(std::size_t r) const
+    {
+        return SpinState::fromPacked(nspins, row_words(r));
+    }
+
+    // sum_i s_i^a s_i^b
+    int overlap(std::size_t a, std::size_t b) const
+    {
+        const uint64_t *wa = row_words(a), *wb = row_words(b);
+        int differ         = 0;
+        for (int k = 0; k < words_per_row; ++k)
+            differ += __builtin_popcountll(wa[k] ^ wb[k]);
+        return nspins - 2 * differ;
+    }
+
+  private:
+    const uint64_t *words = nullptr;
+    std::size_t rows      = 0;
+    int nspins            = 0;
+    int words_per_row     = 0;
+};
+
+/**
+ * @brief Storage of the replicas a sampler records: rows of bit-packed spins, 32 times
+ * smaller than an arma::Mat<int>.
+ *
+ * Rows are whole words, so threads may write different rows concurrently.
+ */
+class PackedReplicas
+{
+  public:
+    // rows states of nspins spins, all -1
+    void resize(std::size_t rows, int nspins)
+    {
+        this->rows          = rows;
+        this->nspins        = nspins;
+        this->words_per_row = SpinState::packedWords(nspins);
+        words.assign(rows * words_per_row, 0);
+        fill(-1);
+    }
+
+    // every spin of every row equal to value (+1 or -1)
+    void fill(int value)
+    {
+        const SpinState s(nspins, value);
+        for (std::size_t r = 0; r < rows; ++r)
+            set_row(r, s);
+    }
+
+    void set_row(std::size_t r, const SpinState &s)
+    {
+        const uint64_t *w = s.packed();
+        for (int k = 0; k < words_per_row; ++k)
+            words[r * words_per_row + k] = w[k];
+    }
+
+    ReplicaView view() const
+    {
+        return ReplicaView(words.data(), rows, nspins);
+    }
+
+  private:
+    std::vector<uint64_t> words;
+    std::size_t rows  = 0;
+    int nspins        = 0;
+    int words_per_row = 0;
+};
+
+} // namespace utils
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+
+/**
+ * @brief The Philox4x32-10 bijection (Salmon et al., "Parallel random numbers: as easy as
+ * 1, 2, 3", SC11): ten rounds of two 32x32 -> 64-bit multiplications mixing a 128-bit
+ * counter under a 64-bit key.
+ *
+ * Every output block depends on its counter and key only, so a stream can be entered at any
+ * position and blocks can be computed in any order, or many at a time in SIMD registers.
+ * tests/test_philox.cpp checks the known-answer vectors of the reference implementation.
+ */
+constexpr std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> ctr,
+                                             std::array<uint32_t, 2> key)
+{
+    constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57; // round multipliers
+    constexpr uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85; // key schedule (Weyl sequence)
+    for (int round = 0; round < 10; ++round)
+    {
+        const uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+        const uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+        ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+        key = {key[0] + W0, key[1] + W1};
+    }
+    return ctr;
+}
+
+// the two uniforms in [0, 1) of a block: 53 bits from each pair of words
+constexpr void philox_to_uniforms(const std::array<uint32_t, 4> &x, double *u)
+{
+    u[0] = static_cast<double>(((static_cast<uint64_t>(x[1]) << 32) | x[0]) >> 11) * 0x1p-53;
+    u[1] = static_cast<double>(((static_cast<uint64_t>(x[3]) << 32) | x[2]) >> 11) * 0x1p-53;
+}
+
+// the block b of stream `stream` under the key seed
+constexpr std::array<uint32_t, 4> philox_block(uint64_t seed, uint64_t stream, uint64_t b)
+{
+    return philox4x32({static_cast<uint32_t>(b), static_cast<uint32_t>(b >> 32),
+                       static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)},
+                      {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)});
+}
+
+// u[2j], u[2j+1] = the uniforms in [0, 1) of block first_block + j of a Philox stream,
+// j < n_blocks; vectorized across the blocks (src/utils/philox.cpp)
+void philox_uniform_batch(uint64_t seed, uint64_t stream, uint64_t first_block, double *u,
+                          std::size_t n_blocks);
+
+/**
+ * @brief Counter-based generator of uniform doubles: the stream of (seed, stream) is the
+ * sequence of Philox blocks with counter (block, stream) under the key seed, each block
+ * giving two doubles with 53 random bits.
+ *
+ * The k-th uniform of a stream is a function of (seed, stream, k) alone. Streams are
+ * independent, so every chain takes its own (stream = chain index) and its numbers do not
+ * depend on which thread runs it or in what order; discard() skips ahead in O(1), and
+ * uniforms() produces a run of them with the vectorized philox_uniform_batch. The state is
+ * three integers (and the spare half of the current block), cheap to copy and store.
+ */
+class Philox
+{
+  public:
+    Philox() = default;
+    Philox(uint64_t seed, uint64_t stream) : seed(seed), stream(stream)
+    {
+    }
+
+    // the next uniform in [0, 1)
+    double uniform()
+    {
+        if (position++ & 1)
+            return spare;
+        double u[2];
+        block(position / 2, u);
+        spare = u[1];
+        return u[0];
+    }
+
+    // u[0..n) = the next n uniforms, as n calls of uniform()
+    void uniforms(double *u, std::size_t n)
+    {
+        if (n > 0 && (position & 1))
+        {
+            *u++ = uniform();
+            --n;
+        }
+        philox_uniform_batch(seed, stream, position / 2, u, n / 2);
+        position += n & ~std::size_t(1);
+        if (n & 1)
+            u[n - 1] = uniform();
+    }
+
+    // uniform integer in [0, n) from the next uniform, for n well below 2^32
+    uint32_t below(uint32_t n)
+    {
+        return static_cast<uint32_t>(uniform() * n);
+    }
+
+    // skips the next n uniforms
+    void discard(uint64_t n)
+    {
+        position += n;
+        if (position & 1)
+        {
+            double u[2];
+            block(position / 2, u);
+            spare = u[1];
+        }
+    }
+
+    // uniforms drawn (or discarded) so far
+    uint64_t tell() const
+    {
+        return position;
+    }
+
+    bool operator==(const Philox &other) const
+    {
+        return seed == other.seed && stream == other.stream && position == other.position;
+    }
+
+  private:
+    uint64_t seed     = 0;
+    uint64_t stream   = 0;
+    uint64_t position = 0;   // index of the next uniform
+    double spare      = 0.0; // second uniform of block position / 2 when position is odd
+
+    void block(uint64_t b, double *u) const
+    {
+        philox_to_uniforms(philox_block(seed, stream, b), u);
+    }
+};
+
+} // namespace utils
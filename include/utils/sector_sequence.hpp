@@ -0,0 +1,104 @@
+#pragma once
+
+#include "utils/spin_state.hpp"
+#include <cstdint>
+
+/**
+ * Walks the spin states of one magnetization sector: the states whose index (bit (n-1-i)
+ * set meaning s_i = -1, as in BinaryPermutationsSequence) has a fixed number of set bits,
+ * n_down = n - k. The indices are visited in increasing order, which is the colexicographic
+ * order of the combinations; Gosper's hack gives the next one in O(1).
+ *
+ * A sequence is the piece [first_rank, first_rank + count) of the sector, so a sector can be
+ * split into equal parts: unrank() finds the index at a rank in the combinatorial number
+ * system. The first C(w, n_down) ranks are the indices within the lowest w bits, so
+ * w = n - 1 restricts the sector to s_0 = +1.
+ */
+class SectorIterator
+{
+  public:
+    using value_type = utils::SpinState;
+
+    SectorIterator(int n, uint64_t x, uint64_t count) : remaining(count), state(n)
+    {
+        state.assign(x);
+    }
+
+    const value_type &operator*() const
+    {
+        return state;
+    }
+
+    SectorIterator &operator++()
+    {
+        if (--remaining > 0)
+        {
+            uint64_t x = state.index();
+            uint64_t c = x & (~x + 1); // lowest set bit
+            uint64_t r = x + c;
+            state.assign((((r ^ x) >> 2) / c) | r);
+        }
+        return *this;
+    }
+
+    bool operator!=(const SectorIterator &other) const
+    {
+        return remaining != other.remaining;
+    }
+
+  private:
+    uint64_t remaining; // states left, including the current one
+    value_type state;
+};
+
+class SectorSequence
+{
+  public:
+    SectorSequence(int n, int n_down, uint64_t first_rank, uint64_t count) :
+        n(n), count(count), first(unrank(n_down, first_rank))
+    {
+    }
+
+    SectorIterator begin() const
+    {
+        return SectorIterator(n, first, count);
+    }
+
+    SectorIterator end() const
+    {
+        return SectorIterator(n, first, 0);
+    }
+
+    // C(n, k), exact for the sector sizes of n <= 64
+    static uint64_t binomial(int n, int k)
+    {
+        if (k < 0 || k > n)
+            return 0;
+        k                   = (k > n - k) ? n - k : k;
+        unsigned __int128 c = 1;
+        for (int i = 0; i < k; ++i)
+            c = c * (n - i) / (i + 1);
+        return static_cast<uint64_t>(c);
+    }
+
+    // index of rank r among the indices with `weight` set bits, in increasing order:
+    // r = sum_i C(v_i, i) over the set bits v_weight > ... > v_1
+    static uint64_t unrank(int weight, uint64_t r)
+    {
+        uint64_t x = 0;
+        for (int i = weight; i >= 1; --i)
+        {
+            int v = i - 1;
+            while (binomial(v + 1, i) <= r)
+                ++v;
+            x |= uint64_t(1) << v;
+            r -= binomial(v, i);
+        }
+        return x;
+    }
+
+  private:
+    int n;
+    uint64_t count;
+    uint64_t first;
+};
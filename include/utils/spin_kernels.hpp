@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace utils
+{
+
+/**
+ * @brief Energy, local-field and moment kernels with the number of spins as a template
+ * parameter.
+ *
+ * Production runs use a few fixed sizes. For those the kernels are compiled with n = N
+ * known, so the spin loops have constant trip counts (unrolled and vectorized without
+ * remainder handling) and the pair index arithmetic folds into constants. N = 0 is the
+ * generic kernel, which reads n at run time; it is used for every other size.
+ *
+ * States are int8 arrays of +-1 (SpinState::data()), J is the packed upper triangle
+ * (i < j, row by row) and J_i is row i of MaxEntCore::J_dense or J_dense_f.
+ */
+
+// sizes with their own instantiation
+inline constexpr int specialized_spin_counts[] = {10, 16, 20, 24, 32, 64};
+
+// the specialization used for n spins: n itself, or 0 (generic)
+constexpr int specializedSpinCount(int n)
+{
+    for (int size : specialized_spin_counts)
+        if (size == n)
+            return n;
+    return 0;
+}
+
+// -sum_i h_i s_i - sum_{i<j} J_ij s_i s_j (the K[k] term is added by the caller)
+template <int N> inline double pairEnergy(const double *h, const double *J, const int8_t *s, int n)
+{
+    if constexpr (N > 0)
+        n = N;
+    double En = 0.0;
+    for (int i = 0; i < n; ++i)
+        En += h[i] * s[i];
+    int idx = 0;
+    for (int i = 0; i < n - 1; ++i)
+        for (int j = i + 1; j < n; ++j)
+            En += J[idx++] * s[i] * s[j];
+    return -En;
+}
+
+// h_i + sum_j J_ij s_j from row i of a CouplingMatrix (zero diagonal): one dot product
+template <int N, typename T>
+inline double denseField(double h_i, const T *J_i, const int8_t *s, int n)
+{
+    if constexpr (N > 0)
+        n = N;
+    T sum = 0;
+#pragma omp simd reduction(+ : sum)
+    for (int j = 0; j < n; ++j)
+        sum += J_i[j] * s[j];
+    return h_i + sum;
+}
+
+// f_j += delta J_ij for every j (J_ii = 0): the local fields after s_i changed by delta
+template <int N, typename T>
+inline void updateDenseFields(double delta, const T *J_i, double *f, int n)
+{
+    if constexpr (N > 0)
+        n = N;
+#pragma omp simd
+    for (int j = 0; j < n; ++j)
+        f[j] += delta * J_i[j];
+}
+
+// m1_i += w_odd s_i and m2_ij += w_even s_i s_j (i < j, packed as J)
+template <int N>
+inline void addMoments(double w_odd, double w_even, const int8_t *s, double *m1, double *m2, int n)
+{
+    if constexpr (N > 0)
+        n = N;
+    for (int i = 0; i < n; ++i)
+        m1[i] += w_odd * s[i];
+    int idx = 0;
+    for (int i = 0; i < n - 1; ++i)
+        for (int j = i + 1; j < n; ++j)
+            m2[idx++] += w_even * s[i] * s[j];
+}
+
+// m3_ijl += w s_i s_j s_l (i < j < l)
+template <int N> inline void addTriplets(double w, const int8_t *s, double *m3, int n)
+{
+    if constexpr (N > 0)
+        n = N;
+    int idx = 0;
+    for (int i = 0; i < n - 2; ++i)
+        for (int j = i + 1; j < n - 1; ++j)
+            for (int l = j + 1; l < n; ++l)
+                m3[idx++] += w * s[i] * s[j] * s[l];
+}
+
+/**
+ * @brief Calls f(std::integral_constant<int, N>{}) with N = specializedSpinCount(n).
+ *
+ * The one runtime dispatch on the number of spins: f instantiates whatever it runs (a
+ * sampler, a kernel table) for N.
+ */
+template <typename F> decltype(auto) withSpinCount(int n, F &&f)
+{
+    switch (specializedSpinCount(n))
+    {
+    case 10:
+        return f(std::integral_constant<int, 10>{});
+    case 16:
+        return f(std::integral_constant<int, 16>{});
+    case 20:
+        return f(std::integral_constant<int, 20>{});
+    case 24:
+        return f(std::integral_constant<int, 24>{});
+    case 32:
+        return f(std::integral_constant<int, 32>{});
+    case 64:
+        return f(std::integral_constant<int, 64>{});
+    default:
+        return f(std::integral_constant<int, 0>{});
+    }
+}
+
+/**
+ * @brief The kernels of one size as function pointers, for loops that dispatch once per
+ * call rather than being instantiated per size themselves.
+ */
+struct SpinKernels
+{
+    int spin_count; // specialization, 0 for the generic kernels
+    double (*pair_energy)(const double *h, const double *J, const int8_t *s, int n);
+    void (*add_moments)(double w_odd, double w_even, const int8_t *s, double *m1, double *m2,
+                        int n);
+    void (*add_triplets)(double w, const int8_t *s, double *m3, int n);
+};
+
+inline const SpinKernels &spinKernels(int n)
+{
+    return withSpinCount(n,
+                         [](auto size) -> const SpinKernels &
+                         {
+                             constexpr int N = decltype(size)::value;
+                             static constexpr SpinKernels kernels = {
+                                 N, &pairEnergy<N>, &addMoments<N>, &addTriplets<N>};
+                             return kernels;
+                         });
+}
+
+// name of the specialization for n spins, for logs and benchmarks: "n=16" or "generic"
+inline std::string spinKernelName(int n)
+{
+    int size = specializedSpinCount(n);
+    return size ? "n=" + std::to_string(size) : std::string("generic");
+}
+
+} // namespace utils
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace utils
+{
+
+/**
+ * @brief Spin configuration of fixed capacity, for the inner loops of the samplers.
+ *
+ * arma::Col<int> states allocate on every copy and every expression (s + 1, conv_to, s.t()).
+ * A SpinState lives entirely inside the object, so copying, flipping and evaluating it never
+ * touches the heap. Spins are kept twice and in sync:
+ *   - bit-packed, spin i at bit (n-1-i) of the words, set <=> s_i = -1: for n <= 64 this is
+ *     the state index of BinaryPermutationsSequence, and popcount gives the number of up
+ *     spins;
+ *   - as an int8 array of +-1 (data(), begin()/end()), for the field and moment loops.
+ */
+class SpinState
+{
+  public:
+    static constexpr int max_spins = 256;
+
+    SpinState() = default;
+
+    // n spins, all equal to value (+1 or -1)
+    explicit SpinState(int n, int value = 1) : n(n)
+    {
+        if (n < 0 || n > max_spins)
+            throw std::length_error("SpinState supports at most 256 spins");
+        fill(value);
+    }
+
+    // state with index x (n <= 64)
+    static SpinState fromIndex(int n, uint64_t x)
+    {
+        SpinState s(n);
+        s.assign(x);
+        return s;
+    }
+
+    // sets the spins from a state index (n <= 64)
+    void assign(uint64_t x)
+    {
+        if (n < 64)
+            x &= (uint64_t(1) << n) - 1;
+        words[0] = x;
+        for (int w = 1; w < n_words; ++w)
+            words[w] = 0;
+        for (int i = 0; i < n; ++i)
+            spins[i] = ((x >> (n - 1 - i)) & 1) ? -1 : 1;
+    }
+
+    void fill(int value)
+    {
+        for (int w = 0; w < n_words; ++w)
+            words[w] = 0;
+        for (int i = 0; i < n; ++i)
+            spins[i] = static_cast<int8_t>(value);
+        if (value < 0)
+            for (int i = 0; i < n; ++i)
+                words[bit(i) / 64] |= uint64_t(1) << (bit(i) % 64);
+    }
+
+    void set(int i, int value)
+    {
+        if (value != spins[i])
+            flip(i);
+    }
+
+    void flip(int i)
+    {
+        spins[i] = static_cast<int8_t>(-spins[i]);
+        words[bit(i) / 64] ^= uint64_t(1) << (bit(i) % 64);
+    }
+
+    int operator()(int i) const
+    {
+        return spins[i];
+    }
+
+    int size() const
+    {
+        return n;
+    }
+
+    // number of spins +1, the k of the k-pairwise terms
+    int numUp() const
+    {
+        int down = 0;
+        for (int w = 0; w < n_words; ++w)
+            down += __builtin_popcountll(words[w]);
+        return n - down;
+    }
+
+    double magnetization() const
+    {
+        return (2.0 * numUp() - n) / n;
+    }
+
+    // state index (n <= 64)
+    uint64_t index() const
+    {
+        return words[0];
+    }
+
+    // the bit-packed spins, packedWords(size()) words
+    const uint64_t *packed() const
+    {
+        return words;
+    }
+
+    static constexpr int packedWords(int n)
+    {
+        return (n + 63) / 64;
+    }
+
+    // state from packed words in the layout of packed()
+    static SpinState fromPacked(int n, const uint64_t *w)
+    {
+        SpinState s(n);
+        for (int k = 0; k < packedWords(n); ++k)
+            s.words[k] = w[k];
+        for (int i = 0; i < n; ++i)
+            s.spins[i] = ((w[s.bit(i) / 64] >> (s.bit(i) % 64)) & 1) ? -1 : 1;
+        return s;
+    }
+
+    const int8_t *data() const
+    {
+        return spins;
+    }
+
+    const int8_t *begin() const
+    {
+        return spins;
+    }
+
+    const int8_t *end() const
+    {
+        return spins + n;
+    }
+
+    bool operator==(const SpinState &other) const
+    {
+        if (n != other.n)
+            return false;
+        for (int w = 0; w < n_words; ++w)
+            if (words[w] != other.words[w])
+                return false;
+        return true;
+    }
+
+  private:
+    static constexpr int n_words = max_spins / 64;
+
+    // position of spin i in the packed words
+    int bit(int i) const
+    {
+        return n - 1 - i;
+    }
+
+    int n = 0;
+    uint64_t words[n_words]             = {}; // bit (n-1-i) set <=> s_i = -1
+    alignas(64) int8_t spins[max_spins] = {}; // s_i = +-1
+};
+
+} // namespace utils
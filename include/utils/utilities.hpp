@@ -1,5 +1,6 @@
 #pragma once
 
+#include "utils/spin_state.hpp"
 #include <algorithm>
 #include <armadillo>
 #include <cmath>
@@ -148,4 +149,18 @@ template <typename T> inline std::string colPrint(const arma::Col<T> &v)
     return out.str();
 }
 
+inline std::string colPrint(const SpinState &s)
+{
+    std::ostringstream out;
+    out << "[";
+    for (int i = 0; i < s.size(); ++i)
+    {
+        out << s(i);
+        if (i + 1 < s.size())
+            out << ", ";
+    }
+    out << "]";
+    return out.str();
+}
+
 } // namespace utils
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace utils
+{
+
+/**
+ * @brief Batched exp_q, logistic and log_q over arrays, for the hot loops of the samplers.
+ *
+ * The scalar utils::exp_q calls std::exp or std::pow once per state, which the compiler
+ * cannot vectorize. These kernels evaluate exp and log with their own range reduction and
+ * polynomials, written as plain loops so that they vectorize, and are compiled for SSE4.2,
+ * AVX2 and AVX-512 (GCC/Clang function multiversioning): the binary picks the widest
+ * instruction set of the CPU at load time.
+ *
+ * Accuracy (tests/test_vector_math.cpp): a few ulp against the scalar functions, in double
+ * and float. Results below the smallest normal number are flushed to zero.
+ *
+ * y may alias x.
+ */
+
+// y[i] = exp_q(x[i], q) = [1 + (1-q) x]_+^(1/(1-q)), and exp(x[i]) for q = 1
+void exp_q_batch(const double *x, double *y, std::size_t n, double q);
+void exp_q_batch(const float *x, float *y, std::size_t n, float q);
+
+// y[i] = 1 / (1 + exp(-x[i])), the heat-bath probability of s_i = +1 with x = 2 beta h_i
+void logistic_batch(const double *x, double *y, std::size_t n);
+void logistic_batch(const float *x, float *y, std::size_t n);
+
+// y[i] = log_q(x[i], q) = (x^(1-q) - 1) / (1-q), and log(x[i]) for q = 1
+void log_q_batch(const double *x, double *y, std::size_t n, double q);
+void log_q_batch(const float *x, float *y, std::size_t n, float q);
+
+} // namespace utils
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+
+namespace utils
+{
+
+/**
+ * @brief In-place, unnormalized fast Walsh–Hadamard transform of a vector of length 2^n_bits.
+ *
+ * Computes y[x] = sum_S (-1)^{popcount(x & S)} a[S] in O(n_bits * 2^n_bits) operations.
+ * Applying the transform twice returns 2^n_bits times the original vector.
+ *
+ * With the state convention of BinaryPermutationsSequence (bit n-1-i set <=> s_i = -1),
+ * (-1)^{popcount(x & S)} is the product of the spins s_i(x) with i in S. Therefore:
+ *   - transforming the Walsh coefficients {-h_i, -J_ij} gives the energy of every state;
+ *   - transforming the Boltzmann weights P(x) gives sum_x P(x) s_i s_j ... for every subset S.
+ *
+ * The first stages run inside cache-sized blocks (one block per thread), the remaining
+ * stages are parallelized over the flattened butterfly index. A vector that fits in one
+ * block is transformed serially, so the function can be called inside a parallel region.
+ *
+ * @param a       Pointer to 2^n_bits values, overwritten by the transform.
+ * @param n_bits  log2 of the vector length.
+ */
+template <typename T> inline void fast_walsh_hadamard(T *a, int n_bits)
+{
+    const std::size_t total      = std::size_t(1) << n_bits;
+    const int block_bits         = std::min(n_bits, 12); // 4096 doubles = 32 kB, fits in L1/L2
+    const std::size_t block_size = std::size_t(1) << block_bits;
+    const std::int64_t n_blocks  = static_cast<std::int64_t>(total / block_size);
+
+    // stages with butterfly distance < block_size: independent blocks
+#pragma omp parallel for schedule(static) if (n_blocks > 1)
+    for (std::int64_t b = 0; b < n_blocks; ++b)
+    {
+        T *blk = a + b * block_size;
+        for (std::size_t len = 1; len < block_size; len <<= 1)
+        {
+            for (std::size_t i = 0; i < block_size; i += 2 * len)
+            {
+                for (std::size_t j = i; j < i + len; ++j)
+                {
+                    T u          = blk[j];
+                    T v          = blk[j + len];
+                    blk[j]       = u + v;
+                    blk[j + len] = u - v;
+                }
+            }
+        }
+    }
+
+    // stages with butterfly distance >= block_size: one butterfly per t in [0, total/2)
+    const std::int64_t half = static_cast<std::int64_t>(total / 2);
+    for (std::size_t len = block_size; len < total; len <<= 1)
+    {
+#pragma omp parallel for schedule(static)
+        for (std::int64_t t = 0; t < half; ++t)
+        {
+            std::size_t low = static_cast<std::size_t>(t) & (len - 1);
+            std::size_t j   = ((static_cast<std::size_t>(t) - low) << 1) | low;
+            T u             = a[j];
+            T v             = a[j + len];
+            a[j]            = u + v;
+            a[j + len]      = u - v;
+        }
+    }
+}
+
+} // namespace utils
@@ -0,0 +1,5 @@
+#pragma once
+#include "core/run_parameters.hpp"
+
+void fullEnsembleShardWorkflow(RunParameters params);
+void fullEnsembleMergeWorkflow(RunParameters params);
@@ -36,8 +36,9 @@ RunParameters parseParameters(const std::string &filename)
     }
 
     std::set<std::string> valid_run_types = {
-        "Full_Ensemble", "Full",     "Heat_Bath", "MC",  "Temperature_Dep",
-        "TDep",          "Gen_Full", "Gen_MC",    "Copy"};
+        "Full_Ensemble", "Full",     "Heat_Bath", "MC",   "Temperature_Dep",
+        "TDep",          "Gen_Full", "Gen_MC",    "Copy", "Full_Shard",
+        "Full_Merge"};
 
     nlohmann::json json_data;
     infile >> json_data;
@@ -72,6 +73,46 @@ RunParameters parseParameters(const std::string &filename)
 
     p.energy_bin = json_data.value("energy_bin", 0.2);
 
+    std::set<std::string> valid_full_engines = {"enumeration", "wht", "gray", "blocked",
+                                                "pruned", "sectors"};
+
+    p.full_engine = json_data.value("full_engine", "enumeration");
+    if (valid_full_engines.count(p.full_engine) == 0)
+    {
+        throw std::runtime_error("Invalid full_engine in " + filename + ": " + p.full_engine);
+    }
+
+    std::set<std::string> valid_energy_caches = {"none", "double", "float"};
+
+    p.energy_cache = json_data.value("energy_cache", "none");
+    if (valid_energy_caches.count(p.energy_cache) == 0)
+    {
+        throw std::runtime_error("Invalid energy_cache in " + filename + ": " + p.energy_cache);
+    }
+
+    p.enum_chunk_log2 = json_data.value("enum_chunk_log2", 22);
+    if (p.enum_chunk_log2 < 1 || p.enum_chunk_log2 > 40)
+    {
+        throw std::runtime_error("enum_chunk_log2 must be in [1, 40] in " + filename);
+    }
+
+    std::set<std::string> valid_enum_precisions = {"double", "float", "validate"};
+
+    p.enum_precision = json_data.value("enum_precision", "double");
+    if (valid_enum_precisions.count(p.enum_precision) == 0)
+    {
+        throw std::runtime_error("Invalid enum_precision in " + filename + ": " +
+                                 p.enum_precision);
+    }
+    p.scratch_dir = json_data.value("scratch_dir", "none");
+
+    p.shard_index = json_data.value("shard_index", 0);
+    p.shard_count = json_data.value("shard_count", 1);
+    if (p.shard_count < 1 || p.shard_index < 0 || p.shard_index >= p.shard_count)
+    {
+        throw std::runtime_error("shard_index must be in [0, shard_count) in " + filename);
+    }
+
     if (p.continue_run == 1)
     {
         logger->info("reading model: {}", p.trained_model_file);
@@ -163,6 +204,11 @@ RunParameters parseParameters(const std::string &filename)
     {
         throw std::runtime_error(p.run_type + " requires 'trained_model_file' in " + filename);
     }
+    bool isSharded = p.run_type == "Full_Shard" || p.run_type == "Full_Merge";
+    if (isSharded && p.trained_model_file == "none")
+    {
+        throw std::runtime_error(p.run_type + " requires 'trained_model_file' in " + filename);
+    }
 
     if (json_data.contains("beta_range") && json_data["beta_range"].is_array())
     {
@@ -223,15 +269,30 @@ RunParameters parseParameters(const std::string &filename)
             p.T_range = arr.get<std::vector<double>>();
         }
     }
+    p.tdep_single_pass = json_data.value("tdep_single_pass", false);
 
     if (json_data.contains("Monte_Carlo"))
     {
-        auto mc              = json_data["Monte_Carlo"];
-        p.step_equilibration = mc.value("step_equilibration", 1000);
-        p.num_samples        = mc.value("num_samples", 1000);
-        p.step_correlation   = mc.value("step_correlation", 100);
-        p.number_repetitions = mc.value("num_repetitions", 20);
-        p.rng_seed           = mc.value("rng_seed", 1);
+        auto mc                = json_data["Monte_Carlo"];
+        p.step_equilibration   = mc.value("step_equilibration", 1000);
+        p.num_samples          = mc.value("num_samples", 1000);
+        p.step_correlation     = mc.value("step_correlation", 100);
+        p.number_repetitions   = mc.value("num_repetitions", 20);
+        p.rng_seed             = mc.value("rng_seed", 1);
+        p.hb_lanes             = mc.value("hb_lanes", 1);
+        p.hb_chains            = mc.value("hb_chains", -1);
+        p.persistent_chains    = mc.value("persistent_chains", false);
+        p.step_reequilibration = mc.value("step_reequilibration", 1000);
+        p.fork_seed_chains     = mc.value("fork_seed_chains", 0);
+        p.step_decorrelation   = mc.value("step_decorrelation", 1000);
+        if (p.hb_lanes != 1 && p.hb_lanes != 8 && p.hb_lanes != 16)
+        {
+            throw std::runtime_error("hb_lanes must be 1, 8 or 16 in " + filename);
+        }
+        if (p.hb_chains < -1)
+        {
+            throw std::runtime_error("hb_chains must be -1, 0 or positive in " + filename);
+        }
     }
 
     if (json_data.contains("Wang_Landau"))
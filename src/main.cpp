@@ -1,6 +1,7 @@
 #include "core/run_parameters.hpp"
 #include "utils/get_logger.hpp"
 #include "workflows/full_ensemble_no_update.hpp"
+#include "workflows/full_ensemble_sharded.hpp"
 #include "workflows/run_temperature_dependence.hpp"
 #include "workflows/training_workflow.hpp"
 #include <iostream>
@@ -10,12 +11,21 @@ int main(int argc, char **argv)
 
     if (argc < 2)
     {
-        std::cout << "Usage: " << argv[0] << " path/to/params.json\n";
+        std::cout << "Usage: " << argv[0] << " path/to/params.json [shard_index]\n";
         return 1;
     }
     std::string param_file = argv[1];
 
     RunParameters params = parseParameters(param_file);
+    if (argc > 2)
+    { // e.g. the index of a batch-array job, overrides shard_index
+        params.shard_index = std::stoi(argv[2]);
+        if (params.shard_index < 0 || params.shard_index >= params.shard_count)
+        {
+            logger->error("shard_index {} not in [0, {})", params.shard_index, params.shard_count);
+            return 1;
+        }
+    }
 
     if (params.run_type == "Full_Ensemble" || params.run_type == "Full")
     {
@@ -33,6 +43,14 @@ int main(int argc, char **argv)
     {
         full_ensemble_no_update(params);
     }
+    else if (params.run_type == "Full_Shard")
+    {
+        fullEnsembleShardWorkflow(params);
+    }
+    else if (params.run_type == "Full_Merge")
+    {
+        fullEnsembleMergeWorkflow(params);
+    }
     else
     {
         logger->warn("{} not recognized", params.run_type);
@@ -16,6 +16,8 @@ BaseTrainer::BaseTrainer(MaxEntCore &core_,
     int n         = core.nspins;
     auto run_type = params.run_type;
     ntriplets     = n * (n - 1) * (n - 2) / 6;
+    spin_kernels  = &core.kernels();
+    logger->info("[BaseTrainer] spin kernels: {}", core.kernelName());
 
     // from parameters file
     eta_h_t = params.eta_h;
@@ -59,6 +61,7 @@ BaseTrainer::BaseTrainer(MaxEntCore &core_,
     read_model_gen      = read_model_gen && utils::isFileType(data_filename, "json");
 
     read_model = read_model || (run_type == "Copy");
+    read_model = read_model || (run_type == "Full_Shard" || run_type == "Full_Merge");
 
     if (read_raw_data)
     { // reads raw data file
@@ -219,4 +222,5 @@ BaseTrainer::BaseTrainer(MaxEntCore &core_,
     {
         throw std::runtime_error("[base_trainer_constructor] Invalid model data type");
     }
+    core.syncCouplings();
 };
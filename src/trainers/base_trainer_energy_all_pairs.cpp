@@ -1,19 +1,8 @@
 #include "trainers/base_trainer.hpp"
 #include <armadillo>
 
-double BaseTrainer::energyAllPairs(arma::Col<int> s)
+double BaseTrainer::energyAllPairs(const utils::SpinState &s) const
 {
-
-    double En = 0.0;
-    for (int i = 0; i < core.nspins; ++i)
-        En += core.h(i) * s(i);
-    int idx = 0;
-    for (int i = 0; i < core.nspins - 1; ++i)
-        for (int j = i + 1; j < core.nspins; ++j)
-            En += core.J(idx++) * s(i) * s(j);
-
-    int k = static_cast<int>(arma::sum(s + 1) / 2);
-    En += core.K[k];
-
-    return -En;
+    double En = spin_kernels->pair_energy(core.h.memptr(), core.J.memptr(), s.data(), core.nspins);
+    return En - core.K[s.numUp()];
 }
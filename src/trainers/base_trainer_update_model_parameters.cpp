@@ -72,6 +72,8 @@ void BaseTrainer::gradUpdateModel(size_t t)
         }
         last_grad_norm_K = grad_norm_K;
     }
+
+    core.syncCouplings(); // the samplers read J through J_dense
 }
 
 void BaseTrainer::gradUpdateModelSeq(size_t t)
@@ -141,6 +143,8 @@ void BaseTrainer::gradUpdateModelSeq(size_t t)
     // }
     last_grad_norm_h = grad_norm_h;
     last_grad_norm_J = grad_norm_J;
+
+    core.syncCouplings();
 }
 
 void BaseTrainer::plawUpdateModel(size_t t)
@@ -187,6 +191,8 @@ void BaseTrainer::plawUpdateModel(size_t t)
             delta_K(i) = delta_k_t;
         }
     }
+
+    core.syncCouplings();
 }
 
 void BaseTrainer::secantUpdateModel(size_t t)
@@ -291,4 +297,6 @@ void BaseTrainer::secantUpdateModel(size_t t)
         last_grad_norm_h = grad_norm_h;
         last_grad_norm_J = grad_norm_J;
     }
+
+    core.syncCouplings();
 }
@@ -24,31 +24,46 @@ void FullEnsembleTrainer::computeModelAverages1(double beta, bool triplets)
 
     // arma::Col<int> s(nspins);
     double Z = 0.0;
-    double E = 0.0;
-    double P = 0.0;
-    BinaryPermutationsSequence sequence(nspins);
+
+    // spin-inversion pairing: only the states with s_0 = +1 are visited, -s has the same
+    // pair term, the opposite field term and nspins - k up spins
+    size_t half = size_t(1) << (nspins - 1);
+    BinaryPermutationsSequence sequence(nspins, 0, half);
 
     for (const auto &s : sequence)
     {
-        E = energyAllPairs(s);
-        P = utils::exp_q(-beta * E, params.q_val);
+        double field = 0.0, pairs = 0.0;
+        for (int i = 0; i < nspins; ++i)
+            field += core.h(i) * s(i);
+        int idx = 0;
+        for (int i = 0; i < nspins - 1; ++i)
+            for (int j = i + 1; j < nspins; ++j)
+                pairs += core.J(idx++) * s(i) * s(j);
+        int k = s.numUp();
 
-        Z += P;
-        avg_energy += P * E;
-        avg_energy_sq += P * E * E;
-        avg_magnetization += P * arma::mean(arma::conv_to<arma::vec>::from(s));
+        double E_up   = -(field + pairs + core.K[k]);
+        double E_down = -(-field + pairs + core.K[nspins - k]);
+        double P_up   = utils::exp_q(-beta * E_up, params.q_val);
+        double P_down = utils::exp_q(-beta * E_down, params.q_val);
+        double P_sum  = P_up + P_down; // weight of even observables
+        double P_diff = P_up - P_down; // weight of odd observables
+
+        Z += P_sum;
+        avg_energy += P_up * E_up + P_down * E_down;
+        avg_energy_sq += P_up * E_up * E_up + P_down * E_down * E_down;
+        avg_magnetization += P_diff * s.magnetization();
 
         // First-order moments
         for (size_t i = 0; i < nspins; ++i)
-            m1_model(i) += P * s(i);
+            m1_model(i) += P_diff * s(i);
 
         // Second-order moments
-        int idx = 0;
+        idx = 0;
         for (size_t i = 0; i < nspins - 1; ++i)
         {
             for (size_t j = i + 1; j < nspins; ++j)
             {
-                m2_model(idx++) += P * s(i) * s(j);
+                m2_model(idx++) += P_sum * s(i) * s(j);
             }
         }
 
@@ -62,15 +77,15 @@ void FullEnsembleTrainer::computeModelAverages1(double beta, bool triplets)
                 {
                     for (size_t k = j + 1; k < nspins; ++k)
                     {
-                        m3_model(idx++) += P * s(i) * s(j) * s(k);
+                        m3_model(idx++) += P_diff * s(i) * s(j) * s(k);
                     }
                 }
             }
         }
 
         // k-pairwise
-        int k = static_cast<int>(arma::sum(s + 1) / 2);
-        pK_model(k) += P; 
+        pK_model(k) += P_up;
+        pK_model(nspins - k) += P_down;
     }
 
     avg_energy /= Z;
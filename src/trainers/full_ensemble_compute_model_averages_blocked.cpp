@@ -0,0 +1,280 @@
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/utilities.hpp"
+#include "utils/vector_math.hpp"
+#include "utils/walsh_hadamard.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <omp.h> // OpenMP
+#include <vector>
+
+/**
+ * @brief Full-ensemble averages with the spins split into an outer prefix and an inner block.
+ *
+ * Spins 0..n_out-1 form the outer block, spins n_out..n-1 the inner block (n_in <= 12), so
+ * state x = (prefix << n_in) | y keeps the BinaryPermutationsSequence ordering.
+ *
+ * Once per call: the inner energies E_in(y) and up-spin counts k_in(y) (2^n_in entries).
+ * Once per prefix: the outer energy E_out and the field b_j = sum_{i out} J_ij s_i that the
+ * prefix applies to every inner spin j; its energy table L(y) = -sum_j b_j s_j(y) is built in
+ * O(2^n_in) by flipping one spin at a time.
+ * The inner loop is then a dense sweep E = E_out + E_in[y] + L[y] - K[k] over tables that
+ * stay in L1/L2, and the 2^n_in weights of a prefix come from one exp_q_batch call. The
+ * inner weights W(y) are Walsh-transformed once per prefix, which gives every inner
+ * correlation; mixed outer/inner moments are products with the outer spins.
+ */
+void FullEnsembleTrainer::computeModelAveragesBlocked(double beta, bool triplets)
+{
+    auto logger = getLogger();
+
+    const int nspins = core.nspins;
+    if (nspins > 40)
+    {
+        logger->error("[computeModelAveragesBlocked] nspins = {} is too large for full "
+                      "enumeration",
+                      nspins);
+        throw std::runtime_error("full enumeration supports nspins <= 40");
+    }
+    const int n_in   = std::min(12, std::max(nspins - 6, (nspins + 1) / 2));
+    const int n_out  = nspins - n_in;
+
+    m1_model.zeros(nspins);
+    m2_model.zeros(core.nedges);
+    m3_model.zeros(ntriplets);
+
+    // k-pairwise
+    pK_model.zeros(nspins + 1);
+
+    avg_energy               = 0.0;
+    avg_energy_sq            = 0.0;
+    avg_magnetization        = 0.0;
+    double Z_partition       = 0.0;
+    size_t N_supp            = 0;
+    const size_t total       = 1ULL << nspins;
+    const size_t n_inner     = 1ULL << n_in;
+    const size_t n_prefix    = 1ULL << n_out;
+    const double one_minus_q = 1.0 - params.q_val;
+
+    max_weight        = -std::numeric_limits<double>::max();
+    max_bracket       = -std::numeric_limits<double>::max();
+    max_weight_energy = -std::numeric_limits<double>::max();
+    // energy histograms (only filled with triplets) cover every possible energy bin
+    const int max_bin = triplets ? core.energyBinBound(params.energy_bin) : 0;
+    GE.reset(-max_bin, max_bin);
+    PE.reset(-max_bin, max_bin);
+
+    auto &h = core.h;
+    auto &J = core.J;
+    auto &K = core.K;
+
+    // bit of inner spin j (local index) in y
+    auto in_bit = [n_in](int j) { return size_t(1) << (n_in - 1 - j); };
+
+    // inner energies from their Walsh coefficients, and inner up-spin counts
+    std::vector<double> E_in(n_inner, 0.0);
+    std::vector<int> k_in(n_inner);
+    for (int j = 0; j < n_in; ++j)
+        E_in[in_bit(j)] = -h(n_out + j);
+    for (int j = 0; j < n_in - 1; ++j)
+        for (int l = j + 1; l < n_in; ++l)
+            E_in[in_bit(j) | in_bit(l)] = -J(core.edges(n_out + j, n_out + l));
+    utils::fast_walsh_hadamard(E_in.data(), n_in);
+    for (size_t y = 0; y < n_inner; ++y)
+        k_in[y] = n_in - __builtin_popcountll(y);
+
+#pragma omp parallel
+    {
+        double local_avg_energy        = 0.0;
+        double local_avg_energy_sq     = 0.0;
+        double local_avg_magnetization = 0.0;
+        double local_Z                 = 0.0;
+        size_t local_N_supp            = 0;
+        double local_max_weight        = -std::numeric_limits<double>::max();
+        double local_max_bracket       = -std::numeric_limits<double>::max();
+        double local_max_weight_energy = -std::numeric_limits<double>::max();
+
+        arma::Col<double> local_m1_model(nspins, arma::fill::zeros);
+        arma::Col<double> local_m2_model(core.nedges, arma::fill::zeros);
+        arma::Col<double> local_m3_model;
+        utils::DenseHistogram<double> local_GE(-max_bin, max_bin); // energy histogram
+        utils::DenseHistogram<double> local_PE(-max_bin, max_bin);
+        if (triplets)
+            local_m3_model.zeros(ntriplets);
+
+        // k-pairwise
+        arma::Col<double> local_pK_model(nspins + 1, arma::fill::zeros);
+
+        std::vector<int> s_out(n_out);
+        std::vector<double> b(n_in);         // field of the prefix on the inner spins
+        std::vector<double> L(n_inner);      // -sum_j b_j s_j(y)
+        std::vector<double> E(n_inner);      // energies of the inner block
+        std::vector<double> W(n_inner);      // inner weights -> their Walsh transform
+        std::vector<double> a1(n_in);        // sum_y W s_j
+        std::vector<double> a2(n_in * n_in); // sum_y W s_j s_l
+
+#pragma omp for schedule(static)
+        for (int64_t p = 0; p < static_cast<int64_t>(n_prefix); ++p)
+        {
+            // outer spins, outer energy and field on the inner block
+            double E_out = 0.0;
+            int k_out    = 0;
+            for (int i = 0; i < n_out; ++i)
+            {
+                s_out[i] = (p >> (n_out - 1 - i)) & 1 ? -1 : +1;
+                k_out += (s_out[i] + 1) / 2;
+                E_out -= h(i) * s_out[i];
+                for (int l = 0; l < i; ++l)
+                    E_out -= J(core.edges(l, i)) * s_out[l] * s_out[i];
+            }
+            for (int j = 0; j < n_in; ++j)
+            {
+                b[j] = 0.0;
+                for (int i = 0; i < n_out; ++i)
+                    b[j] += J(core.edges(i, n_out + j)) * s_out[i];
+            }
+
+            // L(y) flipping the lowest set bit: spin j goes from +1 to -1, adds 2 b_j
+            L[0] = 0.0;
+            for (int j = 0; j < n_in; ++j)
+                L[0] -= b[j];
+            for (size_t y = 1; y < n_inner; ++y)
+            {
+                int j = n_in - 1 - __builtin_ctzll(y);
+                L[y]  = L[y & (y - 1)] + 2.0 * b[j];
+            }
+
+            // dense sweep over the inner block: energies, then all weights in one batch
+            for (size_t y = 0; y < n_inner; ++y)
+            {
+                E[y] = E_out + E_in[y] + L[y] - K[k_out + k_in[y]];
+                W[y] = -beta * E[y];
+            }
+            utils::exp_q_batch(W.data(), W.data(), n_inner, params.q_val);
+
+            for (size_t y = 0; y < n_inner; ++y)
+            {
+                int k          = k_out + k_in[y];
+                double P       = W[y];
+                double bracket = 1.0 - one_minus_q * beta * E[y];
+                if (P > local_max_weight)
+                {
+                    local_max_weight        = P;
+                    local_max_bracket       = bracket;
+                    local_max_weight_energy = E[y];
+                }
+                if (bracket > 0.0)
+                    local_N_supp += 1;
+
+                local_avg_energy += P * E[y];
+                local_avg_energy_sq += P * E[y] * E[y];
+                local_avg_magnetization += P * (2.0 * k - nspins) / nspins;
+                local_pK_model(k) += P;
+
+                if (triplets)
+                {
+                    int E_bin = static_cast<int>(std::round(E[y] / params.energy_bin));
+                    local_GE[E_bin] += 1.0;
+                    local_PE[E_bin] += P;
+                }
+            }
+
+            // all inner correlations of this prefix
+            utils::fast_walsh_hadamard(W.data(), n_in);
+            double Zp = W[0];
+            local_Z += Zp;
+            for (int j = 0; j < n_in; ++j)
+            {
+                a1[j] = W[in_bit(j)];
+                for (int l = j + 1; l < n_in; ++l)
+                    a2[j * n_in + l] = W[in_bit(j) | in_bit(l)];
+            }
+
+            // First-order moments
+            for (int i = 0; i < n_out; ++i)
+                local_m1_model(i) += s_out[i] * Zp;
+            for (int j = 0; j < n_in; ++j)
+                local_m1_model(n_out + j) += a1[j];
+
+            // Second-order moments, in the natural (i < j) order
+            int idx = 0;
+            for (int i = 0; i < nspins - 1; ++i)
+            {
+                for (int j = i + 1; j < nspins; ++j)
+                {
+                    if (j < n_out)
+                        local_m2_model(idx++) += s_out[i] * s_out[j] * Zp;
+                    else if (i < n_out)
+                        local_m2_model(idx++) += s_out[i] * a1[j - n_out];
+                    else
+                        local_m2_model(idx++) += a2[(i - n_out) * n_in + (j - n_out)];
+                }
+            }
+
+            if (triplets)
+            {
+                idx = 0;
+                for (int i = 0; i < nspins - 2; ++i)
+                {
+                    for (int j = i + 1; j < nspins - 1; ++j)
+                    {
+                        for (int l = j + 1; l < nspins; ++l)
+                        {
+                            double v;
+                            if (l < n_out)
+                                v = s_out[i] * s_out[j] * s_out[l] * Zp;
+                            else if (j < n_out)
+                                v = s_out[i] * s_out[j] * a1[l - n_out];
+                            else if (i < n_out)
+                                v = s_out[i] * a2[(j - n_out) * n_in + (l - n_out)];
+                            else
+                                v = W[in_bit(i - n_out) | in_bit(j - n_out) | in_bit(l - n_out)];
+                            local_m3_model(idx++) += v;
+                        }
+                    }
+                }
+            }
+        }
+
+#pragma omp critical
+        {
+            if (local_max_weight > max_weight)
+            {
+                max_weight        = local_max_weight;
+                max_bracket       = local_max_bracket;
+                max_weight_energy = local_max_weight_energy;
+            }
+            avg_energy += local_avg_energy;
+            avg_energy_sq += local_avg_energy_sq;
+            avg_magnetization += local_avg_magnetization;
+            m1_model += local_m1_model;
+            m2_model += local_m2_model;
+            Z_partition += local_Z;
+            pK_model += local_pK_model;
+            N_supp += local_N_supp;
+
+            if (triplets)
+            {
+                m3_model += local_m3_model;
+                GE.merge(local_GE);
+                PE.merge(local_PE);
+            }
+        }
+    } // End of parallel block
+
+    // Normalize final averages
+    avg_energy /= Z_partition;
+    avg_energy_sq /= Z_partition;
+    avg_magnetization /= Z_partition;
+    max_weight /= Z_partition;
+
+    m1_model /= Z_partition;
+    m2_model /= Z_partition;
+    if (triplets)
+    {
+        m3_model /= Z_partition;
+        PE.scale(1.0 / Z_partition);
+    }
+    // k-pairwise
+    pK_model /= Z_partition;
+    f_supp = static_cast<double>(N_supp) / static_cast<double>(total);
+}
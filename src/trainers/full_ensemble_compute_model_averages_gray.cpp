@@ -0,0 +1,245 @@
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/gray_code_sequence.hpp"
+#include "utils/utilities.hpp"
+#include "utils/vector_math.hpp"
+#include <algorithm> // Required for std::min
+#include <armadillo>
+#include <omp.h> // OpenMP
+#include <vector>
+
+/**
+ * @brief Full-ensemble averages walking the states in Gray-code order.
+ *
+ * Consecutive states differ by one spin, so the energy and the local fields
+ *     f_i = h_i + sum_j J_ij s_j
+ * are updated in O(n) per state instead of re-evaluating energyAllPairs in O(n^2).
+ * Flipping s_i -> s_i' changes the pairwise energy by -2 s_i' f_i, every other field
+ * by 2 J_ij s_i', and the number of up spins k by s_i'.
+ *
+ * Each thread walks its own contiguous piece of the Gray-code sequence, starting from the
+ * state gray(start) with a full evaluation. The weights of a block of 128 walked states are
+ * evaluated together with exp_q_batch.
+ */
+void FullEnsembleTrainer::computeModelAveragesGray(double beta, bool triplets)
+{
+    auto logger = getLogger();
+
+    int nspins = core.nspins;
+    int nedges = core.nedges;
+    if (nspins > 40)
+    {
+        logger->error("[computeModelAveragesGray] nspins = {} is too large for full enumeration",
+                      nspins);
+        throw std::runtime_error("full enumeration supports nspins <= 40");
+    }
+    m1_model.zeros(nspins);
+    m2_model.zeros(core.nedges);
+    m3_model.zeros(ntriplets);
+
+    // k-pairwise
+    pK_model.zeros(nspins + 1);
+
+    avg_energy               = 0.0;
+    avg_energy_sq            = 0.0;
+    avg_magnetization        = 0.0;
+    double Z_partition       = 0.0;
+    size_t total             = 1ULL << nspins;
+    size_t N_supp            = 0;
+    const double one_minus_q = 1.0 - params.q_val;
+
+    max_weight        = -std::numeric_limits<double>::max();
+    max_bracket       = -std::numeric_limits<double>::max();
+    max_weight_energy = -std::numeric_limits<double>::max();
+    // energy histograms (only filled with triplets) cover every possible energy bin
+    const int max_bin = triplets ? core.energyBinBound(params.energy_bin) : 0;
+    GE.reset(-max_bin, max_bin);
+    PE.reset(-max_bin, max_bin);
+
+    // a field update is a contiguous row of the dense couplings
+    core.syncCouplings();
+    const auto &J_dense = core.J_dense;
+
+#pragma omp parallel
+    {
+        int num_threads   = omp_get_num_threads();
+        int thread_id     = omp_get_thread_num();
+        size_t chunk_size = (total + num_threads - 1) / num_threads; // ceil
+
+        // Local accumulators per thread
+        double local_avg_energy        = 0.0;
+        double local_avg_energy_sq     = 0.0;
+        double local_avg_magnetization = 0.0;
+        double local_Z                 = 0.0;
+        size_t local_N_supp            = 0;
+        double local_max_weight        = -std::numeric_limits<double>::max();
+        double local_max_bracket       = -std::numeric_limits<double>::max();
+        double local_max_weight_energy = -std::numeric_limits<double>::max();
+
+        arma::Col<double> local_m1_model(nspins, arma::fill::zeros);
+        arma::Col<double> local_m2_model(nedges, arma::fill::zeros);
+        arma::Col<double> local_m3_model;
+        utils::DenseHistogram<double> local_GE(-max_bin, max_bin); // energy histogram
+        utils::DenseHistogram<double> local_PE(-max_bin, max_bin);
+        if (triplets)
+            local_m3_model.zeros(ntriplets);
+
+        // k-pairwise
+        arma::Col<double> local_pK_model(nspins + 1, arma::fill::zeros);
+
+        std::vector<double> field(nspins); // local fields f_i
+        double E_pairs = 0.0;              // energy without the k-pairwise term
+        int k          = 0;                // number of up spins
+
+        // the walk fills a block of states and energies, whose weights are then evaluated
+        // with one exp_q_batch call before the observables are added
+        constexpr size_t block = 128;
+        std::vector<int> states(block * nspins);
+        std::vector<int> k_block(block);
+        std::vector<double> E_block(block), P_block(block);
+        size_t n_block = 0;
+
+        auto add_block = [&]()
+        {
+            for (size_t b = 0; b < n_block; ++b)
+                P_block[b] = -beta * E_block[b];
+            utils::exp_q_batch(P_block.data(), P_block.data(), n_block, params.q_val);
+
+            for (size_t b = 0; b < n_block; ++b)
+            {
+                const int *s   = &states[b * nspins];
+                const int k_up = k_block[b];
+                double E       = E_block[b];
+                double P       = P_block[b];
+                double bracket = 1.0 - one_minus_q * beta * E;
+                if (P > local_max_weight)
+                {
+                    local_max_weight        = P;
+                    local_max_bracket       = bracket;
+                    local_max_weight_energy = E;
+                }
+                if (bracket > 0.0)
+                    local_N_supp += 1;
+
+                local_Z += P;
+                local_avg_energy += P * E;
+                local_avg_energy_sq += P * E * E;
+                local_avg_magnetization += P * (2.0 * k_up - nspins) / nspins;
+
+                // First-order moments
+                for (int i = 0; i < nspins; ++i)
+                    local_m1_model(i) += P * s[i];
+
+                // Second-order moments
+                int idx = 0;
+                for (int i = 0; i < nspins - 1; ++i)
+                {
+                    double Ps_i = P * s[i];
+                    for (int j = i + 1; j < nspins; ++j)
+                        local_m2_model(idx++) += Ps_i * s[j];
+                }
+
+                // k_pairwise: always compute p(k)
+                local_pK_model(k_up) += P;
+
+                if (triplets)
+                {
+                    idx = 0;
+                    for (int i = 0; i < nspins - 2; ++i)
+                        for (int j = i + 1; j < nspins - 1; ++j)
+                        {
+                            double Ps_ij = P * s[i] * s[j];
+                            for (int l = j + 1; l < nspins; ++l)
+                                local_m3_model(idx++) += Ps_ij * s[l];
+                        }
+
+                    int E_bin = static_cast<int>(std::round(E / params.energy_bin));
+                    local_GE[E_bin] += 1.0;
+                    local_PE[E_bin] += P;
+                }
+            }
+            n_block = 0;
+        };
+
+        size_t start = std::min(thread_id * chunk_size, total);
+        size_t end   = std::min(start + chunk_size, total);
+        GrayCodeSequence sequence(nspins, start, end);
+
+        for (const auto &[s, flipped] : sequence)
+        {
+            if (flipped < 0)
+            { // first state of this thread: full evaluation
+                E_pairs = 0.0;
+                k       = 0;
+                for (int i = 0; i < nspins; ++i)
+                {
+                    const double *J_i = J_dense.row(i);
+                    field[i]          = core.h(i);
+                    for (int j = 0; j < nspins; ++j)
+                        field[i] += J_i[j] * s[j];
+                    E_pairs -= 0.5 * s[i] * (core.h(i) + field[i]);
+                    k += (s[i] + 1) / 2;
+                }
+            }
+            else
+            { // one spin flipped: O(n) update
+                int i        = flipped;
+                double two_s = 2.0 * s[i]; // 2 s_i (new value)
+                E_pairs -= two_s * field[i];
+                const double *J_i = J_dense.row(i);
+                for (int j = 0; j < nspins; ++j)
+                    field[j] += two_s * J_i[j]; // J_ii = 0
+                k += s[i];
+            }
+
+            std::copy(s.begin(), s.end(), states.begin() + n_block * nspins);
+            k_block[n_block] = k;
+            E_block[n_block] = E_pairs - core.K[k];
+            if (++n_block == block)
+                add_block();
+        }
+        add_block();
+
+#pragma omp critical
+        {
+            if (local_max_weight > max_weight)
+            {
+                max_weight        = local_max_weight;
+                max_bracket       = local_max_bracket;
+                max_weight_energy = local_max_weight_energy;
+            }
+            avg_energy += local_avg_energy;
+            avg_energy_sq += local_avg_energy_sq;
+            avg_magnetization += local_avg_magnetization;
+            m1_model += local_m1_model;
+            m2_model += local_m2_model;
+            Z_partition += local_Z;
+            pK_model += local_pK_model;
+            N_supp += local_N_supp;
+
+            if (triplets)
+            {
+                m3_model += local_m3_model;
+                GE.merge(local_GE);
+                PE.merge(local_PE);
+            }
+        }
+    } // End of parallel block
+
+    // Normalize final averages
+    avg_energy /= Z_partition;
+    avg_energy_sq /= Z_partition;
+    avg_magnetization /= Z_partition;
+    max_weight /= Z_partition;
+
+    m1_model /= Z_partition;
+    m2_model /= Z_partition;
+    if (triplets)
+    {
+        m3_model /= Z_partition;
+        PE.scale(1.0 / Z_partition);
+    }
+    // k-pairwise
+    pK_model /= Z_partition;
+    f_supp = static_cast<double>(N_supp) / static_cast<double>(total);
+}
@@ -1,202 +1,186 @@
+#include "io/accumulator_file.hpp"
+#include "trainers/ensemble_accumulator.hpp"
 #include "trainers/full_ensemble_trainer.hpp"
-#include "utils/binary_permutations_sequence.hpp"
 #include "utils/get_logger.hpp"
-// #include "utils/utilities.hpp"
 #include <algorithm> // Required for std::min
 #include <armadillo>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <omp.h> // OpenMP
 
 void FullEnsembleTrainer::computeModelAverages(double beta, bool triplets)
 {
     auto logger = getLogger();
 
-    int nspins = core.nspins;
-    int nedges = core.nedges;
-    m1_model.zeros(nspins);
-    m2_model.zeros(core.nedges);
-    m3_model.zeros(ntriplets);
-    // double q_inv = (params.q_val != 1) ? 1.0 / (1.0 - params.q_val) : 0.0;
-
-    // k-pairwise
-    pK_model.zeros(nspins + 1);
-
-    avg_energy         = 0.0;
-    avg_energy_sq      = 0.0;
-    avg_magnetization  = 0.0;
-    double Z_partition = 0.0;
-    size_t total       = 1ULL << nspins;
-    // logger->info("Total number of configurations: {}", total);
-
-    size_t N_supp = 0; // number of configurations with P>0
-    // double f_supp            = 0.0; // fraction of supported configurations
-    const double one_minus_q = 1.0 - params.q_val;
-
-    max_weight        = -std::numeric_limits<double>::max();
-    max_bracket       = -std::numeric_limits<double>::max();
-    max_weight_energy = -std::numeric_limits<double>::max();
-    ;
-    // logger->info("Number of threads: {}", omp_get_num_threads());
-    GE.clear();
-    PE.clear();
-#pragma omp parallel
+    if (params.full_engine == "wht")
     {
-        int num_threads   = omp_get_num_threads();
-        int thread_id     = omp_get_thread_num();
-        size_t chunk_size = (total + num_threads - 1) / num_threads; // ceil
-
-        // Local accumulators per thread
-        double local_avg_energy        = 0.0;
-        double local_avg_energy_sq     = 0.0;
-        double local_avg_magnetization = 0.0;
-        double local_Z                 = 0.0;
-        double local_bracket           = 1.0;
-        size_t local_N_supp            = 0;
-        double local_max_weight        = -std::numeric_limits<double>::max();
-        double local_max_bracket       = -std::numeric_limits<double>::max();
-        double local_max_weight_energy = -std::numeric_limits<double>::max();
-        ;
-
-        arma::Col<double> local_m1_model(nspins, arma::fill::zeros);
-        arma::Col<double> local_m2_model(nedges, arma::fill::zeros);
-        arma::Col<double> local_m3_model;
-        std::unordered_map<int, double> local_GE, local_PE; // energy histogram
-
-        if (triplets)
-        {
-            local_m3_model.set_size(ntriplets);
-            local_m3_model.zeros();
-            local_GE.clear();
-            local_PE.clear();
-        }
+        computeModelAveragesWHT(beta, triplets);
+        return;
+    }
+    else if (params.full_engine == "gray")
+    {
+        computeModelAveragesGray(beta, triplets);
+        return;
+    }
+    else if (params.full_engine == "blocked")
+    {
+        computeModelAveragesBlocked(beta, triplets);
+        return;
+    }
+    else if (params.full_engine == "pruned")
+    {
+        computeModelAveragesPruned(beta, triplets);
+        return;
+    }
+    else if (params.full_engine == "sectors")
+    {
+        computeModelAveragesSectors(beta, triplets);
+        return;
+    }
 
-        // k-pairwise
-        arma::Col<double> local_pK_model(nspins + 1, arma::fill::zeros);
+    EnsembleAccumulator acc = enumerateChunks(0, numberOfChunks(), beta, triplets);
+    if (params.enum_precision == "validate")
+    {
+        // same states with the float kernel; the double sums are kept
+        enum_single_precision = true;
+        EnsembleAccumulator acc_single = enumerateChunks(0, numberOfChunks(), beta, triplets);
+        enum_single_precision = false;
+        singlePrecisionDeviation(acc, acc_single);
+    }
+    storeAverages(acc, triplets);
+}
 
-        double E = 0.0, P = 0.0;
+/**
+ * @brief Number of enumeration chunks: the half hypercube s_0 = +1 (the spin-inversion
+ * partners are added by enumerateChunk) in pieces of 2^enum_chunk_log2 states.
+ */
+uint64_t FullEnsembleTrainer::numberOfChunks() const
+{
+    const uint64_t half       = uint64_t(1) << (core.nspins - 1);
+    const uint64_t chunk_size = std::min(half, uint64_t(1) << params.enum_chunk_log2);
+    return (half + chunk_size - 1) / chunk_size;
+}
 
-        size_t start = thread_id * chunk_size;
-        size_t end   = std::min(start + chunk_size, total);
-        BinaryPermutationsSequence sequence(nspins, start, end);
+/**
+ * @brief Unnormalized sums over the chunks [first_chunk, last_chunk).
+ *
+ * Chunks are handed out dynamically to the threads; each is summed into its own accumulator
+ * and then added to the thread total, so per-thread memory does not grow with the number of
+ * states. With scratch_dir set every finished chunk is also written to chunkDirectory(), and
+ * chunks already there are read instead of enumerated.
+ */
+EnsembleAccumulator FullEnsembleTrainer::enumerateChunks(uint64_t first_chunk,
+                                                         uint64_t last_chunk,
+                                                         double beta,
+                                                         bool triplets)
+{
+    auto logger = getLogger();
 
-        // logger->info("thread {} start {} end {}", thread_id, start, end);
-        for (const auto &s : sequence)
-        {
-            E             = energyAllPairs(s);
-            P             = utils::exp_q(-beta * E, params.q_val);
-            local_bracket = 1.0 - one_minus_q * beta * E;
-            if (P > local_max_weight)
-            {
-                local_max_weight        = P;
-                local_max_bracket       = local_bracket;
-                local_max_weight_energy = E;
-            }
+    const int nspins = core.nspins;
+    if (nspins > 40)
+    {
+        logger->error("[enumerateChunks] nspins = {} is too large for full enumeration", nspins);
+        throw std::runtime_error("full enumeration supports nspins <= 40");
+    }
 
-            // Support counting: Tsallis q<1 typically yields exact zeros via cutoff.
-            if (local_bracket > 0.0)
-            {
-                local_N_supp += 1;
-            }
+    const uint64_t half       = uint64_t(1) << (nspins - 1);
+    const uint64_t chunk_size = std::min(half, uint64_t(1) << params.enum_chunk_log2);
+    const uint64_t n_chunks   = last_chunk - first_chunk;
+    const bool report         = n_chunks >= 64; // long runs log their progress
+
+    if (params.energy_cache != "none")
+        updateEnergyTable();
+    core.syncCouplings(); // J_dense_f of the float kernel
+
+    // checkpointing: every finished chunk is saved under scratch_dir/enum_<fingerprint>/, and
+    // chunks already there (same model, beta, q, chunk size) are read instead of enumerated
+    const uint64_t fingerprint  = enumerationFingerprint(beta, triplets);
+    const std::string chunk_dir = chunkDirectory(beta, triplets);
+    if (!chunk_dir.empty())
+        std::filesystem::create_directories(chunk_dir);
+
+    // energy histograms (only filled with triplets) cover every possible energy bin
+    const int max_bin = triplets ? core.energyBinBound(params.energy_bin) : -1;
+
+    const ChunkKernel kernel = selectChunkKernel(triplets);
+
+    EnsembleAccumulator acc(nspins, core.nedges, ntriplets, max_bin);
+    std::atomic<uint64_t> chunks_done{0};
+    std::atomic<uint64_t> chunks_reused{0};
+    auto t_start = std::chrono::steady_clock::now();
 
-            local_Z += P;
-            local_avg_energy += P * E;
-            local_avg_energy_sq += P * E * E;
-            local_avg_magnetization += P * arma::mean(arma::conv_to<arma::vec>::from(s));
+#pragma omp parallel
+    {
+        // per-thread memory: two accumulators, independent of the number of states
+        EnsembleAccumulator local_acc(nspins, core.nedges, ntriplets, max_bin);
+        EnsembleAccumulator chunk_acc(nspins, core.nedges, ntriplets, max_bin);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int64_t c = first_chunk; c < static_cast<int64_t>(last_chunk); ++c)
+        {
+            uint64_t begin = c * chunk_size;
+            uint64_t end   = std::min(begin + chunk_size, half);
 
-            // First-order moments
-            for (size_t i = 0; i < nspins; ++i)
-                local_m1_model(i) += P * s(i);
+            // partial sums of one chunk, then added to the thread total
+            chunk_acc.reset();
+            std::string chunk_file;
+            if (!chunk_dir.empty())
+                chunk_file = chunk_dir + "/chunk_" + std::to_string(c) + ".bin";
 
-            // Second-order moments
-            int idx = 0;
-            for (size_t i = 0; i < nspins - 1; ++i)
+            if (!chunk_file.empty() && io::readAccumulator(chunk_file, fingerprint, chunk_acc))
             {
-                for (size_t j = i + 1; j < nspins; ++j)
-                {
-                    local_m2_model(idx++) += P * s(i) * s(j);
-                }
+                chunks_reused += 1;
             }
+            else
+            {
+                chunk_acc.reset();
+                (this->*kernel)(begin, end, beta, chunk_acc);
+                if (!chunk_file.empty())
+                    io::writeAccumulator(chunk_acc, fingerprint, chunk_file);
+            }
+            local_acc.merge(chunk_acc);
 
-            // k_pairwise: always compute p(k)
-            int k = static_cast<int>(arma::sum(s + 1) / 2);
-            local_pK_model(k) += P;
-
-            if (triplets)
+            uint64_t done = ++chunks_done;
+            if (report && (done * 20) / n_chunks != ((done - 1) * 20) / n_chunks)
             {
-                // Third-order moments
-                idx = 0;
-                for (size_t i = 0; i < nspins - 2; ++i)
-                {
-                    for (size_t j = i + 1; j < nspins - 1; ++j)
-                    {
-                        for (size_t k = j + 1; k < nspins; ++k)
-                        {
-                            local_m3_model(idx++) += P * s(i) * s(j) * s(k);
-                        }
-                    }
-                }
-
-                int E_bin = static_cast<int>(std::round(E / params.energy_bin));
-                local_GE[E_bin] += 1.0;
-                local_PE[E_bin] += P;
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                               t_start)
+                                     .count();
+                logger->info("[enumerateChunks] {}/{} chunks ({:.0f}%) in {:.1f} s", done,
+                             n_chunks, 100.0 * done / n_chunks, elapsed);
             }
         }
 
 #pragma omp critical
         {
-            if (local_max_weight > max_weight)
-            {
-                max_weight        = local_max_weight;
-                max_bracket       = local_max_bracket;
-                max_weight_energy = local_max_weight_energy;
-            }
-            avg_energy += local_avg_energy;
-            avg_energy_sq += local_avg_energy_sq;
-            avg_magnetization += local_avg_magnetization;
-            m1_model += local_m1_model;
-            m2_model += local_m2_model;
-            Z_partition += local_Z;
-            // k_pairwise: always compute p(k)
-            pK_model += local_pK_model;
-
-            N_supp += local_N_supp;
-
-            if (triplets)
-            {
-                m3_model += local_m3_model;
-
-                // merge local_H -> global H
-                for (const auto &[bin, weight] : local_GE)
-                {
-                    GE[bin] += weight; // accumulate
-                }
-                for (const auto &[bin, weight] : local_PE)
-                {
-                    PE[bin] += weight; // accumulate
-                }
-            }
+            acc.merge(local_acc);
         }
     } // End of parallel block
 
-    // Normalize final averages
-    avg_energy /= Z_partition;
-    avg_energy_sq /= Z_partition;
-    avg_magnetization /= Z_partition;
-    max_weight /= Z_partition;
-
-    m1_model /= Z_partition;
-    m2_model /= Z_partition;
-    if (triplets)
+    if (!chunk_dir.empty())
     {
-        m3_model /= Z_partition;
-        for (auto &kv : PE)
-        {
-            kv.second /= Z_partition; // now H[bin] ~ P_q(E_bin)
-        }
+        if (chunks_reused > 0)
+            logger->info("[enumerateChunks] reused {}/{} chunks from {}",
+                         chunks_reused.load(), n_chunks, chunk_dir);
+        retireChunkDirectory(chunk_dir);
     }
-    // k-pairwise
-    pK_model /= Z_partition;
-    f_supp = static_cast<double>(N_supp) / static_cast<double>(total);
-    // logger->info(
-    //     "Support fraction f_supp(beta={:.6g}, q={:.6g}) = {:.6g} (N_supp = {}), total = {:d}",
-    //     beta, params.q_val, f_supp, N_supp, total);
+
+    return acc;
+}
+
+/**
+ * @brief Enumeration kernel for the current model and settings, chosen once per
+ * enumerateChunks call.
+ *
+ * K is only updated with k_pairwise, but a model read from file may carry K terms either
+ * way, so the K-free kernels are used whenever K is all zero.
+ */
+FullEnsembleTrainer::ChunkKernel FullEnsembleTrainer::selectChunkKernel(bool triplets) const
+{
+    auto nonzero         = [](double K_k) { return K_k != 0.0; };
+    const bool k_terms   = std::any_of(core.K.begin(), core.K.end(), nonzero);
+    const bool boltzmann = (params.q_val == 1.0);
+    return enum_single_precision ? chunkKernelFloat(k_terms, boltzmann, triplets)
+                                 : chunkKernel(k_terms, boltzmann, triplets);
 }
@@ -0,0 +1,235 @@
+#include "trainers/ensemble_accumulator.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/spin_state.hpp"
+#include "utils/utilities.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <omp.h> // OpenMP
+#include <vector>
+
+namespace
+{
+/**
+ * @brief Depth-first walk over the spins of one thread, skipping subtrees outside the support.
+ *
+ * At depth d spins 0..d-1 are fixed. Their energy E_fixed and the fields they apply to the
+ * free spins, f_j = h_j + sum_{i<d} J_ij s_i, bound every completion:
+ *     E = E_fixed - sum_{j>=d} f_j s_j - sum_{d<=j<l} J_jl s_j s_l - K[k]
+ *     |E - E_fixed + K[k]| <= sum_{j>=d} |f_j| + sum_{d<=j<l} |J_jl|
+ * with k between the up spins fixed so far and that plus n - d. A subtree whose lower bound
+ * reaches E_cut has zero weight everywhere and is counted by its size alone; one whose upper
+ * bound stays below E_cut is entirely in the support, and its states are no longer tested.
+ * The bounds only tighten with depth, so a subtree is decided once.
+ */
+class SupportSearch
+{
+  public:
+    SupportSearch(const MaxEntCore &core,
+                  const RunParameters &params,
+                  double beta,
+                  bool triplets,
+                  EnsembleAccumulator &acc) :
+        core(core), kernels(core.kernels()), acc(acc), n(core.nspins), beta(beta),
+        q(params.q_val), triplets(triplets), s(core.nspins)
+    {
+        // 1 - (1-q) beta E > 0  <=>  E < E_cut, with a margin for the rounding of the bounds
+        E_cut  = 1.0 / ((1.0 - q) * beta);
+        margin = 1e-9 * (1.0 + std::abs(E_cut));
+
+        field.resize((n + 1) * n);
+        free_pairs.assign(n + 1, 0.0);
+        for (int d = n - 2; d >= 0; --d)
+        {
+            free_pairs[d] = free_pairs[d + 1];
+            for (int j = d + 1; j < n; ++j)
+                free_pairs[d] += std::abs(core.J_dense.row(d)[j]);
+        }
+    }
+
+    // spins 0..depth-1 from the bits of prefix (BinaryPermutationsSequence order), then the
+    // subtree below them
+    void searchFrom(uint64_t prefix, int depth)
+    {
+        double E_fixed = 0.0;
+        int k          = 0;
+        for (int j = 0; j < n; ++j)
+            field[j] = core.h(j);
+        for (int d = 0; d < depth; ++d)
+        {
+            const int s_d = ((prefix >> (depth - 1 - d)) & 1) ? -1 : 1;
+            s.set(d, s_d);
+            E_fixed -= field[d * n + d] * s_d;
+            k += (s_d == 1);
+            const double *J_d = core.J_dense.row(d);
+            for (int j = d + 1; j < n; ++j)
+                field[(d + 1) * n + j] = field[d * n + j] + J_d[j] * s_d;
+        }
+        visit(depth, E_fixed, k, false);
+    }
+
+    uint64_t n_leaves = 0; // states evaluated, the rest were pruned
+
+  private:
+    const MaxEntCore &core;
+    const utils::SpinKernels &kernels;
+    EnsembleAccumulator &acc;
+    const int n;
+    const double beta, q;
+    const bool triplets; // third-order moments
+    double E_cut, margin;
+
+    utils::SpinState s;             // spins 0..d-1 of the current node
+    std::vector<double> field;      // field[d * n + j] = f_j at depth d, j >= d
+    std::vector<double> free_pairs; // free_pairs[d] = sum_{d<=j<l} |J_jl|
+
+    void visit(int d, double E_fixed, int k, bool inside)
+    {
+        if (d == n)
+        {
+            addState(E_fixed - core.K(k), k, inside);
+            return;
+        }
+
+        if (!inside)
+        {
+            const double *f = &field[d * n];
+            double spread   = free_pairs[d];
+            for (int j = d; j < n; ++j)
+                spread += std::abs(f[j]);
+            double K_min = core.K(k), K_max = core.K(k);
+            for (int kk = k + 1; kk <= k + n - d; ++kk)
+            {
+                K_min = std::min(K_min, core.K(kk));
+                K_max = std::max(K_max, core.K(kk));
+            }
+
+            const uint64_t size = uint64_t(1) << (n - d);
+            if (E_fixed - spread - K_max >= E_cut + margin)
+            {
+                acc.n_states += size; // zero weight everywhere below
+                return;
+            }
+            if (E_fixed + spread - K_min < E_cut - margin)
+            {
+                acc.n_supp += size; // every state below is in the support
+                inside = true;
+            }
+        }
+
+        const double *f   = &field[d * n];
+        const double *J_d = core.J_dense.row(d);
+        double *f_next    = &field[(d + 1) * n];
+        for (int s_d : {1, -1})
+        {
+            s.set(d, s_d);
+#pragma omp simd
+            for (int j = d + 1; j < n; ++j)
+                f_next[j] = f[j] + J_d[j] * s_d;
+            visit(d + 1, E_fixed - f[d] * s_d, k + (s_d == 1), inside);
+        }
+    }
+
+    // the observables of one complete state, as in enumerateChunk
+    void addState(double E, int k, bool inside)
+    {
+        n_leaves += 1;
+        acc.n_states += 1;
+
+        const double bracket = 1.0 - (1.0 - q) * beta * E;
+        if (!inside && bracket > 0.0)
+            acc.n_supp += 1;
+
+        const double P = utils::exp_q(-beta * E, q);
+        if (P > acc.max_weight)
+        {
+            acc.max_weight        = P;
+            acc.max_bracket       = bracket;
+            acc.max_weight_energy = E;
+        }
+        if (P == 0.0)
+            return;
+
+        acc.Z += P;
+        acc.energy += P * E;
+        acc.energy_sq += P * E * E;
+        acc.magnetization += P * (2.0 * k - n) / n;
+        acc.pK(k) += P;
+        kernels.add_moments(P, P, s.data(), acc.m1.memptr(), acc.m2.memptr(), n);
+        if (triplets)
+            kernels.add_triplets(P, s.data(), acc.m3.memptr(), n);
+    }
+};
+} // namespace
+
+/**
+ * @brief Full-ensemble averages for q < 1 visiting only the support of the Tsallis weights.
+ *
+ * For q < 1, exp_q(-beta E) is exactly zero once 1 - (1-q) beta E <= 0. Sharp models put
+ * most of the hypercube there, yet the enumeration engines evaluate every state to find it.
+ * Here the states are walked depth first over the spins with energy bounds on each partial
+ * assignment (SupportSearch), and subtrees entirely outside the support are skipped. f_supp
+ * follows from the sizes of the pruned and fully supported subtrees.
+ *
+ * The top `depth` spins are enumerated as independent prefixes, handed out dynamically to
+ * the threads. Pruned states are never evaluated, so they cannot be binned: the energy
+ * histograms GE and PE are left empty rather than holding a partial density of states. For
+ * q >= 1 or beta <= 0 every state is in the support and the chunked enumeration is used
+ * instead, histograms included.
+ */
+void FullEnsembleTrainer::computeModelAveragesPruned(double beta, bool triplets)
+{
+    auto logger = getLogger();
+
+    const int nspins = core.nspins;
+    if (params.q_val >= 1.0 || beta <= 0.0)
+    {
+        logger->debug("[computeModelAveragesPruned] q = {}, beta = {}: no cutoff, enumerating",
+                      params.q_val, beta);
+        storeAverages(enumerateChunks(0, numberOfChunks(), beta, triplets), triplets);
+        return;
+    }
+    if (nspins > 62)
+    {
+        logger->error("[computeModelAveragesPruned] nspins = {} is too large", nspins);
+        throw std::runtime_error("full_engine 'pruned' supports nspins <= 62");
+    }
+
+    core.syncCouplings(); // the fields are updated from rows of J_dense
+
+    const int depth = std::min(nspins, 10);
+
+    // no energy histograms: they would miss every pruned state
+    EnsembleAccumulator acc(nspins, core.nedges, triplets ? ntriplets : 0);
+    uint64_t n_leaves = 0;
+
+#pragma omp parallel
+    {
+        EnsembleAccumulator local_acc(nspins, core.nedges, triplets ? ntriplets : 0);
+        SupportSearch search(core, params, beta, triplets, local_acc);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int64_t prefix = 0; prefix < (int64_t(1) << depth); ++prefix)
+            search.searchFrom(prefix, depth);
+
+#pragma omp critical
+        {
+            acc.merge(local_acc);
+            n_leaves += search.n_leaves;
+        }
+    } // End of parallel block
+
+    logger->debug("[computeModelAveragesPruned] evaluated {} of {} states, {} in the support",
+                  n_leaves, acc.n_states, acc.n_supp);
+    if (acc.Z == 0.0)
+    {
+        logger->error("[computeModelAveragesPruned] no state in the support at beta = {}",
+                      beta);
+        throw std::runtime_error("empty support in full_engine 'pruned'");
+    }
+    storeAverages(acc, triplets);
+    if (triplets)
+        logger->warn("[computeModelAveragesPruned] pruned states are not binned: GE and PE "
+                     "are left empty (use another full_engine for the density of states)");
+}
@@ -0,0 +1,178 @@
+#include "trainers/ensemble_accumulator.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/sector_sequence.hpp"
+#include "utils/utilities.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <omp.h> // OpenMP
+#include <vector>
+
+namespace
+{
+// a piece of one magnetization sector: ranks [first_rank, first_rank + count)
+struct SectorPiece
+{
+    int k; // up spins of the visited states
+    uint64_t first_rank;
+    uint64_t count;
+};
+} // namespace
+
+/**
+ * @brief Full-ensemble averages enumerated one magnetization sector k (up spins) at a time.
+ *
+ * Every state of sector k is visited with SectorSequence; its spin inversion lies in sector
+ * n - k and shares the pair term, so sectors k > n/2 are enumerated together with their
+ * partners and the self-paired sector k = n/2 only over s_0 = +1. Each sector is summed into
+ * its own EnsembleAccumulator, which gives the per-sector Z_k, <s_i | k> and <s_i s_j | k>
+ * (get_sector_Z, get_sector_m1, get_sector_m2) next to the usual averages.
+ *
+ * Sector sizes C(n, k) differ by orders of magnitude, so the sectors are cut into pieces of
+ * at most 2^enum_chunk_log2 states and the pieces are handed out largest first, rather
+ * than splitting the index range evenly.
+ */
+void FullEnsembleTrainer::computeModelAveragesSectors(double beta, bool triplets)
+{
+    auto logger = getLogger();
+
+    const int nspins = core.nspins;
+    if (nspins > 40)
+    {
+        logger->error("[computeModelAveragesSectors] nspins = {} is too large for full "
+                      "enumeration",
+                      nspins);
+        throw std::runtime_error("full enumeration supports nspins <= 40");
+    }
+
+    const uint64_t all_bits = (uint64_t(1) << nspins) - 1;
+    const bool use_table    = (params.energy_cache != "none");
+    const double q          = params.q_val;
+    const auto &kernels     = core.kernels();
+    const int n_triplets    = triplets ? ntriplets : 0;
+    if (use_table)
+        updateEnergyTable();
+
+    // energy histograms (only filled with triplets) cover every possible energy bin
+    const int max_bin = triplets ? core.energyBinBound(params.energy_bin) : -1;
+
+    // sectors k > n/2 over all n spins, k = n/2 over spins 1..n-1 (s_0 = +1)
+    const uint64_t piece_size = uint64_t(1) << params.enum_chunk_log2;
+    std::vector<SectorPiece> pieces;
+    for (int k = nspins / 2; k <= nspins; ++k)
+    {
+        if (2 * k < nspins)
+            continue;
+        const int width     = (2 * k == nspins) ? nspins - 1 : nspins;
+        const uint64_t size = SectorSequence::binomial(width, nspins - k);
+        for (uint64_t first = 0; first < size; first += piece_size)
+            pieces.push_back({k, first, std::min(piece_size, size - first)});
+    }
+    std::stable_sort(pieces.begin(), pieces.end(),
+                     [](const SectorPiece &a, const SectorPiece &b) { return a.count > b.count; });
+
+    std::vector<EnsembleAccumulator> sectors(
+        nspins + 1, EnsembleAccumulator(nspins, core.nedges, n_triplets));
+    EnsembleAccumulator acc(nspins, core.nedges, n_triplets, max_bin);
+
+#pragma omp parallel
+    {
+        // per-thread memory: one accumulator per sector and the energy histograms
+        std::vector<EnsembleAccumulator> local(
+            nspins + 1, EnsembleAccumulator(nspins, core.nedges, n_triplets));
+        utils::DenseHistogram<double> local_GE, local_PE;
+        if (triplets)
+        {
+            local_GE.reset(-max_bin, max_bin);
+            local_PE.reset(-max_bin, max_bin);
+        }
+
+        // scalar observables of one state, as in enumerateChunk, then its moments
+        auto add_state = [&](const utils::SpinState &s, double E, int k, int sign)
+        {
+            EnsembleAccumulator &a = local[k];
+            const double P         = utils::exp_q(-beta * E, q);
+            const double bracket   = 1.0 - (1.0 - q) * beta * E;
+            if (P > a.max_weight)
+            {
+                a.max_weight        = P;
+                a.max_bracket       = bracket;
+                a.max_weight_energy = E;
+            }
+            if (q == 1.0 || bracket > 0.0)
+                a.n_supp += 1;
+            a.n_states += 1;
+            a.Z += P;
+            a.energy += P * E;
+            a.energy_sq += P * E * E;
+            a.magnetization += P * (2.0 * k - nspins) / nspins;
+            a.pK(k) += P;
+            if (triplets)
+            {
+                int E_bin = static_cast<int>(std::round(E / params.energy_bin));
+                local_GE[E_bin] += 1.0;
+                local_PE[E_bin] += P;
+            }
+            if (P == 0.0)
+                return;
+
+            // s enters with sign +1, its inversion -s with sign -1
+            kernels.add_moments(sign * P, P, s.data(), a.m1.memptr(), a.m2.memptr(), nspins);
+            if (triplets)
+                kernels.add_triplets(sign * P, s.data(), a.m3.memptr(), nspins);
+        };
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t p = 0; p < pieces.size(); ++p)
+        {
+            const int k = pieces[p].k;
+            for (const auto &s : SectorSequence(nspins, nspins - k, pieces[p].first_rank,
+                                                pieces[p].count))
+            {
+                double E_up, E_down;
+                if (use_table)
+                {
+                    E_up   = tableEnergy(s.index()) - core.K[k];
+                    E_down = tableEnergy(s.index() ^ all_bits) - core.K[nspins - k];
+                }
+                else
+                {
+                    double field = 0.0;
+                    for (int i = 0; i < nspins; ++i)
+                        field += core.h(i) * s(i);
+                    double E = kernels.pair_energy(core.h.memptr(), core.J.memptr(), s.data(),
+                                                   nspins);
+                    E_up     = E - core.K[k];
+                    E_down   = E + 2.0 * field - core.K[nspins - k];
+                }
+                add_state(s, E_up, k, 1);
+                add_state(s, E_down, nspins - k, -1);
+            }
+        }
+
+#pragma omp critical
+        {
+            for (int k = 0; k <= nspins; ++k)
+                sectors[k].merge(local[k]);
+            acc.GE.merge(local_GE);
+            acc.PE.merge(local_PE);
+        }
+    } // End of parallel block
+
+    sector_Z.zeros(nspins + 1);
+    sector_m1.zeros(nspins, nspins + 1);
+    sector_m2.zeros(core.nedges, nspins + 1);
+    for (int k = 0; k <= nspins; ++k)
+    {
+        acc.merge(sectors[k]);
+        sector_Z(k) = sectors[k].Z;
+        if (sectors[k].Z > 0.0)
+        {
+            sector_m1.col(k) = sectors[k].m1 / sectors[k].Z;
+            sector_m2.col(k) = sectors[k].m2 / sectors[k].Z;
+        }
+        logger->debug("[computeModelAveragesSectors] k = {}: {} states, Z_k = {}", k,
+                      sectors[k].n_states, sectors[k].Z);
+    }
+    storeAverages(acc, triplets);
+}
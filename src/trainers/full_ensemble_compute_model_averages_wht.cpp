@@ -0,0 +1,199 @@
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/utilities.hpp"
+#include "utils/vector_math.hpp"
+#include "utils/walsh_hadamard.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <omp.h> // OpenMP
+#include <vector>
+
+/**
+ * @brief Full-ensemble averages with fast Walsh–Hadamard transforms, O(n 2^n).
+ *
+ * h and J are the Walsh coefficients of the energy, and m1, m2, m3 are the Walsh
+ * coefficients of P(s). One buffer of 2^n doubles holds, in turn:
+ *   1. the energy coefficients {-h_i, -J_ij}  -> WHT -> E(s) for all states,
+ *   2. the weights P(s) = exp_q(-beta E(s))    -> WHT -> sum_s P(s) prod_{i in S} s_i.
+ * The k-pairwise term depends only on the number of up spins and is added state by state.
+ *
+ * State x follows the BinaryPermutationsSequence convention: bit (n-1-i) set <=> s_i = -1.
+ */
+void FullEnsembleTrainer::computeModelAveragesWHT(double beta, bool triplets)
+{
+    auto logger = getLogger();
+
+    int nspins = core.nspins;
+    if (nspins > 30)
+    {
+        logger->error("[computeModelAveragesWHT] nspins = {} needs 2^n doubles", nspins);
+        throw std::runtime_error("full_engine 'wht' supports nspins <= 30");
+    }
+
+    m1_model.zeros(nspins);
+    m2_model.zeros(core.nedges);
+    m3_model.zeros(ntriplets);
+
+    // k-pairwise
+    pK_model.zeros(nspins + 1);
+
+    avg_energy               = 0.0;
+    avg_energy_sq            = 0.0;
+    avg_magnetization        = 0.0;
+    double Z_partition       = 0.0;
+    size_t N_supp            = 0;
+    const size_t total       = 1ULL << nspins;
+    const double one_minus_q = 1.0 - params.q_val;
+
+    max_weight        = -std::numeric_limits<double>::max();
+    max_bracket       = -std::numeric_limits<double>::max();
+    max_weight_energy = -std::numeric_limits<double>::max();
+    // energy histograms (only filled with triplets) cover every possible energy bin
+    const int max_bin = triplets ? core.energyBinBound(params.energy_bin) : 0;
+    GE.reset(-max_bin, max_bin);
+    PE.reset(-max_bin, max_bin);
+
+    // index of spin i in the state bits
+    auto bit = [nspins](int i) { return size_t(1) << (nspins - 1 - i); };
+
+    // (1) energy of every state from its Walsh coefficients, or from the cached table
+    std::vector<double> w(total, 0.0);
+    int idx = 0;
+    if (params.energy_cache != "none")
+    {
+        updateEnergyTable();
+#pragma omp parallel for schedule(static)
+        for (int64_t x = 0; x < static_cast<int64_t>(total); ++x)
+            w[x] = tableEnergy(x);
+    }
+    else
+    {
+        for (int i = 0; i < nspins; ++i)
+            w[bit(i)] = -core.h(i);
+        for (int i = 0; i < nspins - 1; ++i)
+            for (int j = i + 1; j < nspins; ++j)
+                w[bit(i) | bit(j)] = -core.J(idx++);
+
+        utils::fast_walsh_hadamard(w.data(), nspins);
+    }
+
+    // (2) weights, scalar observables and histograms; w[x] <- P(x)
+#pragma omp parallel
+    {
+        double local_avg_energy        = 0.0;
+        double local_avg_energy_sq     = 0.0;
+        double local_avg_magnetization = 0.0;
+        double local_Z                 = 0.0;
+        size_t local_N_supp            = 0;
+        double local_max_weight        = -std::numeric_limits<double>::max();
+        double local_max_bracket       = -std::numeric_limits<double>::max();
+        double local_max_weight_energy = -std::numeric_limits<double>::max();
+
+        arma::Col<double> local_pK_model(nspins + 1, arma::fill::zeros);
+        utils::DenseHistogram<double> local_GE(-max_bin, max_bin); // energy histogram
+        utils::DenseHistogram<double> local_PE(-max_bin, max_bin);
+
+        // energies of a block of states, then their weights with one vectorized exp_q
+        constexpr int64_t block = 1024;
+        std::vector<double> E_block(block);
+#pragma omp for schedule(static)
+        for (int64_t x0 = 0; x0 < static_cast<int64_t>(total); x0 += block)
+        {
+            const int64_t n_block = std::min<int64_t>(block, static_cast<int64_t>(total) - x0);
+            double *P_block       = w.data() + x0;
+            for (int64_t b = 0; b < n_block; ++b)
+            {
+                int k      = nspins - __builtin_popcountll(x0 + b); // number of up spins
+                E_block[b] = w[x0 + b] - core.K[k];
+                P_block[b] = -beta * E_block[b];
+            }
+            utils::exp_q_batch(P_block, P_block, static_cast<size_t>(n_block), params.q_val);
+
+            for (int64_t b = 0; b < n_block; ++b)
+            {
+                int k    = nspins - __builtin_popcountll(x0 + b);
+                double E = E_block[b];
+                double P = P_block[b];
+
+                double bracket = 1.0 - one_minus_q * beta * E;
+                if (P > local_max_weight)
+                {
+                    local_max_weight        = P;
+                    local_max_bracket       = bracket;
+                    local_max_weight_energy = E;
+                }
+                if (bracket > 0.0)
+                    local_N_supp += 1;
+
+                local_Z += P;
+                local_avg_energy += P * E;
+                local_avg_energy_sq += P * E * E;
+                local_avg_magnetization += P * (2.0 * k - nspins) / nspins;
+                local_pK_model(k) += P;
+
+                if (triplets)
+                {
+                    int E_bin = static_cast<int>(std::round(E / params.energy_bin));
+                    local_GE[E_bin] += 1.0;
+                    local_PE[E_bin] += P;
+                }
+            }
+        }
+
+#pragma omp critical
+        {
+            if (local_max_weight > max_weight)
+            {
+                max_weight        = local_max_weight;
+                max_bracket       = local_max_bracket;
+                max_weight_energy = local_max_weight_energy;
+            }
+            avg_energy += local_avg_energy;
+            avg_energy_sq += local_avg_energy_sq;
+            avg_magnetization += local_avg_magnetization;
+            Z_partition += local_Z;
+            pK_model += local_pK_model;
+            N_supp += local_N_supp;
+
+            GE.merge(local_GE);
+            PE.merge(local_PE);
+        }
+    } // End of parallel block
+
+    // (3) all correlations sum_x P(x) prod_{i in S} s_i(x) at once
+    utils::fast_walsh_hadamard(w.data(), nspins);
+
+    for (int i = 0; i < nspins; ++i)
+        m1_model(i) = w[bit(i)];
+
+    idx = 0;
+    for (int i = 0; i < nspins - 1; ++i)
+        for (int j = i + 1; j < nspins; ++j)
+            m2_model(idx++) = w[bit(i) | bit(j)];
+
+    if (triplets)
+    {
+        idx = 0;
+        for (int i = 0; i < nspins - 2; ++i)
+            for (int j = i + 1; j < nspins - 1; ++j)
+                for (int k = j + 1; k < nspins; ++k)
+                    m3_model(idx++) = w[bit(i) | bit(j) | bit(k)];
+    }
+
+    // Normalize final averages
+    avg_energy /= Z_partition;
+    avg_energy_sq /= Z_partition;
+    avg_magnetization /= Z_partition;
+    max_weight /= Z_partition;
+
+    m1_model /= Z_partition;
+    m2_model /= Z_partition;
+    if (triplets)
+    {
+        m3_model /= Z_partition;
+        PE.scale(1.0 / Z_partition);
+    }
+    // k-pairwise
+    pK_model /= Z_partition;
+    f_supp = static_cast<double>(N_supp) / static_cast<double>(total);
+}
@@ -0,0 +1,84 @@
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/walsh_hadamard.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Enumerates all 2^n states once and groups them by exact energy.
+ *
+ * The pairwise energies come from the cached energy table when params.energy_cache is set,
+ * otherwise from one Walsh-Hadamard transform of {-h_i, -J_ij}; the k-pairwise term is added
+ * per state. States are sorted by energy and runs of identical energies are merged, so
+ * utils::thermalAverages reproduces <E>, <E^2>, <M>, f_supp and the max-weight state of
+ * computeModelAverages for any beta and q.
+ */
+utils::EnergyLevels FullEnsembleTrainer::computeEnergyLevels()
+{
+    auto logger = getLogger();
+
+    const int nspins   = core.nspins;
+    const size_t total = size_t(1) << nspins;
+    if (nspins > 30)
+    {
+        logger->error("[computeEnergyLevels] nspins = {} needs 2^n energies", nspins);
+        throw std::runtime_error("computeEnergyLevels supports nspins <= 30");
+    }
+
+    // (energy, number of up spins) of every state
+    std::vector<std::pair<double, int>> states(total);
+    if (params.energy_cache != "none")
+    {
+        updateEnergyTable();
+#pragma omp parallel for schedule(static)
+        for (int64_t x = 0; x < static_cast<int64_t>(total); ++x)
+            states[x].first = tableEnergy(x);
+    }
+    else
+    {
+        auto bit = [nspins](int i) { return size_t(1) << (nspins - 1 - i); };
+        std::vector<double> w(total, 0.0);
+        for (int i = 0; i < nspins; ++i)
+            w[bit(i)] = -core.h(i);
+        int idx = 0;
+        for (int i = 0; i < nspins - 1; ++i)
+            for (int j = i + 1; j < nspins; ++j)
+                w[bit(i) | bit(j)] = -core.J(idx++);
+        utils::fast_walsh_hadamard(w.data(), nspins);
+
+#pragma omp parallel for schedule(static)
+        for (int64_t x = 0; x < static_cast<int64_t>(total); ++x)
+            states[x].first = w[x];
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int64_t x = 0; x < static_cast<int64_t>(total); ++x)
+    {
+        int k            = nspins - __builtin_popcountll(x); // number of up spins
+        states[x].first  = states[x].first - core.K[k];
+        states[x].second = k;
+    }
+
+    std::sort(states.begin(), states.end());
+
+    utils::EnergyLevels levels;
+    levels.n_states = static_cast<double>(total);
+    for (size_t x = 0; x < total; ++x)
+    {
+        double E   = states[x].first;
+        double mag = (2.0 * states[x].second - nspins) / nspins;
+        if (levels.energy.empty() || E != levels.energy.back())
+        {
+            levels.energy.push_back(E);
+            levels.degeneracy.push_back(0.0);
+            levels.magnetization.push_back(0.0);
+        }
+        levels.degeneracy.back() += 1.0;
+        levels.magnetization.back() += mag;
+    }
+
+    logger->debug("[computeEnergyLevels] {} states, {} distinct energies", total,
+                  levels.energy.size());
+    return levels;
+}
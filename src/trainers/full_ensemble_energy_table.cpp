@@ -0,0 +1,136 @@
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/walsh_hadamard.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+// a parameter that changed: the state bits of its spins and its delta
+struct ParamDelta
+{
+    uint64_t mask;
+    double delta;
+};
+
+// energy of every state from its Walsh coefficients {-h_i, -J_ij}
+template <typename T>
+void rebuild_table(std::vector<T> &table, const arma::Col<double> &h, const arma::Col<double> &J,
+                   int nspins)
+{
+    auto bit = [nspins](int i) { return uint64_t(1) << (nspins - 1 - i); };
+
+    std::fill(table.begin(), table.end(), T(0));
+    for (int i = 0; i < nspins; ++i)
+        table[bit(i)] = static_cast<T>(-h(i));
+    int idx = 0;
+    for (int i = 0; i < nspins - 1; ++i)
+        for (int j = i + 1; j < nspins; ++j)
+            table[bit(i) | bit(j)] = static_cast<T>(-J(idx++));
+
+    utils::fast_walsh_hadamard(table.data(), nspins);
+}
+
+// E(x) += -delta * prod_{i in mask} s_i(x), with prod s_i = (-1)^popcount(x & mask)
+template <typename T>
+void patch_table(std::vector<T> &table, const std::vector<ParamDelta> &changes)
+{
+    const int64_t total = static_cast<int64_t>(table.size());
+#pragma omp parallel for schedule(static)
+    for (int64_t x = 0; x < total; ++x)
+    {
+        double dE = 0.0;
+        for (const auto &c : changes)
+        {
+            bool odd = __builtin_popcountll(static_cast<uint64_t>(x) & c.mask) & 1;
+            dE += odd ? c.delta : -c.delta;
+        }
+        table[x] += static_cast<T>(dE);
+    }
+}
+} // namespace
+
+/**
+ * @brief Brings the cached energy table in line with the current h and J.
+ *
+ * The table holds E(x) = -sum_i h_i s_i - sum_{i<j} J_ij s_i s_j for every state x
+ * (the k-pairwise term is added by the callers). A change dh_i shifts E(x) by -dh_i s_i(x)
+ * and a change dJ_ij by -dJ_ij s_i(x) s_j(x), so a few changed parameters (as after
+ * gradUpdateModelSeq) are applied in one pass over the table. When more than nspins
+ * parameters changed, or after many patches have accumulated rounding errors, the table is
+ * rebuilt with a Walsh-Hadamard transform in O(n 2^n).
+ */
+void FullEnsembleTrainer::updateEnergyTable()
+{
+    auto logger = getLogger();
+
+    const int nspins        = core.nspins;
+    const size_t total      = size_t(1) << nspins;
+    const int max_changes   = nspins; // a patch pass costs ~ one stage of the transform each
+    const int max_patches   = 256;
+    const bool single_prec  = (params.energy_cache == "float");
+    const size_t table_size = single_prec ? energy_table_f.size() : energy_table.size();
+    auto bit                = [nspins](int i) { return uint64_t(1) << (nspins - 1 - i); };
+
+    if (nspins > 30)
+    {
+        logger->error("[updateEnergyTable] nspins = {} needs 2^n table entries", nspins);
+        throw std::runtime_error("energy_cache supports nspins <= 30");
+    }
+
+    bool rebuild = (table_size != total) || (energy_table_patches >= max_patches);
+
+    std::vector<ParamDelta> changes;
+    if (!rebuild)
+    {
+        for (int i = 0; i < nspins; ++i)
+        {
+            double d = core.h(i) - energy_table_h(i);
+            if (d != 0.0)
+                changes.push_back({bit(i), d});
+        }
+        int idx = 0;
+        for (int i = 0; i < nspins - 1; ++i)
+        {
+            for (int j = i + 1; j < nspins; ++j, ++idx)
+            {
+                double d = core.J(idx) - energy_table_J(idx);
+                if (d != 0.0)
+                    changes.push_back({bit(i) | bit(j), d});
+            }
+        }
+        if (changes.empty())
+            return;
+        rebuild = static_cast<int>(changes.size()) > max_changes;
+    }
+
+    if (rebuild)
+    {
+        if (single_prec)
+        {
+            energy_table.clear();
+            energy_table_f.resize(total);
+            rebuild_table(energy_table_f, core.h, core.J, nspins);
+        }
+        else
+        {
+            energy_table_f.clear();
+            energy_table.resize(total);
+            rebuild_table(energy_table, core.h, core.J, nspins);
+        }
+        energy_table_patches = 0;
+        logger->debug("[updateEnergyTable] rebuilt {} energies", total);
+    }
+    else
+    {
+        if (single_prec)
+            patch_table(energy_table_f, changes);
+        else
+            patch_table(energy_table, changes);
+        energy_table_patches += 1;
+        logger->debug("[updateEnergyTable] patched {} parameters", changes.size());
+    }
+
+    energy_table_h = core.h;
+    energy_table_J = core.J;
+}
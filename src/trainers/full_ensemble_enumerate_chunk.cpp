@@ -0,0 +1,275 @@
+#include "trainers/ensemble_accumulator.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/binary_permutations_sequence.hpp"
+#include "utils/utilities.hpp"
+#include "utils/vector_math.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief Adds the states [begin, end) and their spin inversions to acc.
+ *
+ * Indices below 2^(n-1) have s_0 = +1. The partner -s of every visited state s has the same
+ * pair term, the opposite field term and nspins - k up spins, so one evaluation gives both
+ * energies. Even moments (m2) are weighted by P(s) + P(-s), odd ones (m1, m3, magnetization)
+ * by P(s) - P(-s).
+ *
+ * @param begin, end  Range of state indices, end <= 2^(nspins-1).
+ * @tparam KTerms     K[k] terms in the energy; without them K is all zero and not read.
+ * @tparam Boltzmann  q = 1: every state is in the support.
+ * @tparam Triplets   Third-order moments and energy histograms.
+ */
+template <bool KTerms, bool Boltzmann, bool Triplets>
+void FullEnsembleTrainer::enumerateChunk(uint64_t begin,
+                                         uint64_t end,
+                                         double beta,
+                                         EnsembleAccumulator &acc)
+{
+    const int nspins         = core.nspins;
+    const uint64_t all_bits  = (uint64_t(1) << nspins) - 1;
+    const bool use_table     = (params.energy_cache != "none");
+    const double q           = Boltzmann ? 1.0 : params.q_val;
+    const double one_minus_q = 1.0 - q;
+    const auto &kernels      = core.kernels(); // moment loops specialized on nspins
+
+    // scalar observables of one state: weight, energy, support, p(k) and histograms
+    auto add_state = [&](double E, double P, int k)
+    {
+        const double bracket = Boltzmann ? 1.0 : 1.0 - one_minus_q * beta * E;
+        if (P > acc.max_weight)
+        {
+            acc.max_weight        = P;
+            acc.max_bracket       = bracket;
+            acc.max_weight_energy = E;
+        }
+
+        // Support counting: Tsallis q<1 typically yields exact zeros via cutoff.
+        if (Boltzmann || bracket > 0.0)
+            acc.n_supp += 1;
+
+        acc.n_states += 1;
+        acc.Z += P;
+        acc.energy += P * E;
+        acc.energy_sq += P * E * E;
+
+        // k_pairwise: always compute p(k)
+        acc.pK(k) += P;
+
+        if constexpr (Triplets)
+        {
+            int E_bin = static_cast<int>(std::round(E / params.energy_bin));
+            acc.GE[E_bin] += 1.0;
+            acc.PE[E_bin] += P;
+        }
+    };
+
+    // Weights are evaluated a block at a time with the vectorized exp_q: one pass over the
+    // block collects both energies of every pair, the next adds its observables.
+    constexpr uint64_t block = 128;
+    alignas(64) double E[2 * block]; // E_up of the block, then E_down
+    alignas(64) double P[2 * block];
+    int k_up[block];
+
+    for (uint64_t x0 = begin; x0 < end; x0 += block)
+    {
+        const uint64_t x1    = std::min(end, x0 + block);
+        const size_t n_block = static_cast<size_t>(x1 - x0);
+        double *E_up         = E;
+        double *E_down       = E + n_block;
+
+        BinaryPermutationsSequence sequence(nspins, x0, x1);
+        uint64_t x = x0; // index of s in the energy table
+        size_t b   = 0;
+        for (const auto &s : sequence)
+        {
+            int k               = nspins - __builtin_popcountll(x & all_bits);
+            k_up[b]             = k;
+            const double K_up   = KTerms ? core.K[k] : 0.0;
+            const double K_down = KTerms ? core.K[nspins - k] : 0.0;
+            if (use_table)
+            {
+                E_up[b]   = tableEnergy(x) - K_up;
+                E_down[b] = tableEnergy(x ^ all_bits) - K_down;
+            }
+            else
+            {
+                // -s flips the field term only: E(-s) = E(s) + 2 sum_i h_i s_i
+                const double E_pairs =
+                    kernels.pair_energy(core.h.memptr(), core.J.memptr(), s.data(), nspins);
+                double field = 0.0;
+                for (int i = 0; i < nspins; ++i)
+                    field += core.h(i) * s(i);
+                E_up[b]   = E_pairs - K_up;
+                E_down[b] = E_pairs + 2.0 * field - K_down;
+            }
+            ++x;
+            ++b;
+        }
+
+        for (size_t i = 0; i < 2 * n_block; ++i)
+            P[i] = -beta * E[i];
+        utils::exp_q_batch(P, P, 2 * n_block, q);
+
+        b = 0;
+        for (const auto &s : sequence)
+        {
+            const int k         = k_up[b];
+            const double P_up   = P[b];
+            const double P_down = P[n_block + b];
+            const double P_sum  = P_up + P_down; // weight of even observables
+            const double P_diff = P_up - P_down; // weight of odd observables
+
+            add_state(E_up[b], P_up, k);
+            add_state(E_down[b], P_down, nspins - k);
+            acc.magnetization += P_diff * (2.0 * k - nspins) / nspins;
+            ++b;
+
+            // First- and second-order moments
+            kernels.add_moments(P_diff, P_sum, s.data(), acc.m1.memptr(), acc.m2.memptr(),
+                                nspins);
+
+            // Third-order moments
+            if constexpr (Triplets)
+                kernels.add_triplets(P_diff, s.data(), acc.m3.memptr(), nspins);
+        }
+    }
+}
+
+/**
+ * @brief Instantiation of enumerateChunk for a combination of model flags.
+ */
+FullEnsembleTrainer::ChunkKernel FullEnsembleTrainer::chunkKernel(bool k_terms,
+                                                                  bool boltzmann,
+                                                                  bool triplets)
+{
+    static constexpr ChunkKernel kernels[8] = {
+        &FullEnsembleTrainer::enumerateChunk<false, false, false>,
+        &FullEnsembleTrainer::enumerateChunk<false, false, true>,
+        &FullEnsembleTrainer::enumerateChunk<false, true, false>,
+        &FullEnsembleTrainer::enumerateChunk<false, true, true>,
+        &FullEnsembleTrainer::enumerateChunk<true, false, false>,
+        &FullEnsembleTrainer::enumerateChunk<true, false, true>,
+        &FullEnsembleTrainer::enumerateChunk<true, true, false>,
+        &FullEnsembleTrainer::enumerateChunk<true, true, true>,
+    };
+    return kernels[4 * k_terms + 2 * boltzmann + triplets];
+}
+
+/**
+ * @brief Normalizes the sums of a complete enumeration into the model averages.
+ */
+void FullEnsembleTrainer::storeAverages(const EnsembleAccumulator &acc, bool triplets)
+{
+    const double Z = acc.Z;
+
+    avg_energy        = acc.energy / Z;
+    avg_energy_sq     = acc.energy_sq / Z;
+    avg_magnetization = acc.magnetization / Z;
+    max_weight        = acc.max_weight / Z;
+    max_bracket       = acc.max_bracket;
+    max_weight_energy = acc.max_weight_energy;
+
+    m1_model = acc.m1 / Z;
+    m2_model = acc.m2 / Z;
+    m3_model.zeros(ntriplets);
+    GE.clear();
+    PE.clear();
+    if (triplets)
+    {
+        m3_model = acc.m3 / Z;
+        GE       = acc.GE;
+        PE       = acc.PE;
+        PE.scale(1.0 / Z); // now PE[bin] ~ P_q(E_bin)
+    }
+    // k-pairwise
+    pK_model = acc.pK / Z;
+    f_supp   = static_cast<double>(acc.n_supp) / static_cast<double>(acc.n_states);
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of everything a full enumeration depends on.
+ *
+ * Chunk files written with another model, temperature, q, chunk size, precision or energy
+ * cache are never reused.
+ */
+uint64_t FullEnsembleTrainer::enumerationFingerprint(double beta, bool triplets) const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto add      = [&hash](const void *data, size_t n_bytes)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t b = 0; b < n_bytes; ++b)
+        {
+            hash ^= bytes[b];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    int flags[3] = {core.nspins, params.enum_chunk_log2, triplets ? 1 : 0};
+    add(flags, sizeof(flags));
+    add(&beta, sizeof(beta));
+    add(&params.q_val, sizeof(params.q_val));
+    add(&params.energy_bin, sizeof(params.energy_bin));
+    add(core.h.memptr(), core.h.n_elem * sizeof(double));
+    add(core.J.memptr(), core.J.n_elem * sizeof(double));
+    add(core.K.memptr(), core.K.n_elem * sizeof(double));
+    if (enum_single_precision)
+        add("float", 5);
+    // the cached energies are rounded to float with energy_cache = "float"
+    add(params.energy_cache.data(), params.energy_cache.size());
+    return hash;
+}
+
+/**
+ * @brief Directory of the chunk files of one evaluation: scratch_dir/enum_<fingerprint>,
+ * or "" when scratch_dir is "none".
+ */
+std::string FullEnsembleTrainer::chunkDirectory(double beta, bool triplets) const
+{
+    if (params.scratch_dir == "none")
+        return "";
+    std::ostringstream dir;
+    dir << params.scratch_dir << "/enum_" << std::hex << std::setw(16) << std::setfill('0')
+        << enumerationFingerprint(beta, triplets);
+    return dir.str();
+}
+
+/**
+ * @brief Bookkeeping after an evaluation finished writing chunk_dir.
+ *
+ * The first evaluation after a model checkpoint (or the start of the run) is the one a run
+ * resumed from that checkpoint repeats, so its directory stays until the next checkpoint.
+ * Any other finished evaluation is only kept until a newer one finishes, then removed.
+ */
+void FullEnsembleTrainer::retireChunkDirectory(const std::string &chunk_dir)
+{
+    if (!last_chunk_dir.empty() && last_chunk_dir != chunk_dir &&
+        last_chunk_dir != checkpoint_chunk_dir)
+        std::filesystem::remove_all(last_chunk_dir);
+    last_chunk_dir = chunk_dir;
+
+    if (next_dir_is_checkpoint)
+    {
+        checkpoint_chunk_dir   = chunk_dir;
+        next_dir_is_checkpoint = false;
+    }
+}
+
+/**
+ * @brief Removes the chunk files kept so far.
+ *
+ * Called once the current model is safely written (model checkpoint or final file): a
+ * restart from that file never needs them again, only the evaluation that follows.
+ */
+void FullEnsembleTrainer::clearEnumerationCheckpoints()
+{
+    for (const auto &dir : {checkpoint_chunk_dir, last_chunk_dir})
+        if (!dir.empty())
+            std::filesystem::remove_all(dir);
+    checkpoint_chunk_dir.clear();
+    last_chunk_dir.clear();
+    next_dir_is_checkpoint = true;
+}
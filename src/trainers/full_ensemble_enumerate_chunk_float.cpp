@@ -0,0 +1,327 @@
+#include "trainers/ensemble_accumulator.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/utilities.hpp"
+#include "utils/vector_math.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+// states per block: one AVX-512 register of floats, or two AVX2 registers
+constexpr int lanes = 16;
+
+// sum of a block of lanes, halving the width each step (pairwise summation)
+inline float lane_sum(float *v)
+{
+    for (int width = lanes / 2; width > 0; width /= 2)
+    {
+#pragma omp simd
+        for (int l = 0; l < width; ++l)
+            v[l] += v[l + width];
+    }
+    return v[0];
+}
+} // namespace
+
+/**
+ * @brief Single-precision version of enumerateChunk, 16 states at a time.
+ *
+ * The states of a block are stored spin by spin (s[i * 16 + l]), so energies, weights and
+ * moments are computed in float across the 16 lanes. Weights are taken relative to the
+ * largest weight of the block, P = P_ref * w with w in [0, 1]:
+ *   q = 1:  w = exp(-beta (E - E_ref)),
+ *   q != 1: w = (y / y_ref)^(1/(1-q)),  y = 1 - (1-q) beta E,
+ * so float never overflows. A block's lane sums of w are reduced pairwise, then multiplied
+ * by P_ref and added to acc in double. No float sum runs over more than 16 terms, and the
+ * averages stay within single_precision_tolerance of the double kernel (see
+ * singlePrecisionDeviation). The template flags are those of enumerateChunk.
+ */
+template <bool KTerms, bool Boltzmann, bool Triplets>
+void FullEnsembleTrainer::enumerateChunkFloat(uint64_t begin,
+                                              uint64_t end,
+                                              double beta,
+                                              EnsembleAccumulator &acc)
+{
+    const int nspins         = core.nspins;
+    const uint64_t all_bits  = (uint64_t(1) << nspins) - 1;
+    const bool use_table     = (params.energy_cache != "none");
+    const double q           = Boltzmann ? 1.0 : params.q_val;
+    const double one_minus_q = 1.0 - q;
+    const float beta_f       = static_cast<float>(beta);
+    const float omq_f        = static_cast<float>(one_minus_q);
+    const float inv_omq_f    = Boltzmann ? 0.0f : static_cast<float>(1.0 / one_minus_q);
+    const float q_f          = static_cast<float>(q);
+    const float inv_n        = 1.0f / static_cast<float>(nspins);
+
+    const std::vector<float> h(core.h.begin(), core.h.end());
+    const auto &J_dense_f = core.J_dense_f; // synced by enumerateChunks
+    const std::vector<float> K(core.K.begin(), core.K.end());
+
+    std::vector<float> s(static_cast<size_t>(nspins) * lanes); // spin i of lane l: s[i*lanes+l]
+    alignas(64) float E_up[lanes], E_down[lanes], y_up[lanes], y_down[lanes];
+    alignas(64) float w_up[lanes], w_down[lanes], w_sum[lanes], w_diff[lanes];
+    alignas(64) float field[lanes], pairs[lanes], tmp[lanes];
+    int k_up[lanes];
+
+    for (uint64_t x0 = begin; x0 < end; x0 += lanes)
+    {
+        const int n_valid = static_cast<int>(std::min<uint64_t>(lanes, end - x0));
+
+        for (int i = 0; i < nspins; ++i)
+        {
+            const int shift = nspins - 1 - i;
+            float *s_i      = &s[static_cast<size_t>(i) * lanes];
+            for (int l = 0; l < lanes; ++l)
+                s_i[l] = (((x0 + l) >> shift) & 1) ? -1.0f : 1.0f;
+        }
+        for (int l = 0; l < lanes; ++l)
+            k_up[l] = nspins - __builtin_popcountll((x0 + l) & all_bits);
+
+        // (1) energies of the block and of its spin-inverted partners
+        if (use_table)
+        {
+            for (int l = 0; l < lanes; ++l)
+            {
+                uint64_t x = x0 + std::min(l, n_valid - 1); // padding lanes repeat the last state
+                E_up[l]    = static_cast<float>(tableEnergy(x));
+                E_down[l]  = static_cast<float>(tableEnergy(x ^ all_bits));
+                if constexpr (KTerms)
+                {
+                    E_up[l] -= K[k_up[l]];
+                    E_down[l] -= K[nspins - k_up[l]];
+                }
+            }
+        }
+        else
+        {
+            std::fill(field, field + lanes, 0.0f);
+            std::fill(pairs, pairs + lanes, 0.0f);
+            for (int i = 0; i < nspins; ++i)
+            {
+                const float *s_i = &s[static_cast<size_t>(i) * lanes];
+                const float *J_i = J_dense_f.row(i);
+#pragma omp simd
+                for (int l = 0; l < lanes; ++l)
+                    field[l] += h[i] * s_i[l];
+                for (int j = i + 1; j < nspins; ++j)
+                {
+                    const float *s_j = &s[static_cast<size_t>(j) * lanes];
+                    const float J_ij = J_i[j];
+#pragma omp simd
+                    for (int l = 0; l < lanes; ++l)
+                        pairs[l] += J_ij * s_i[l] * s_j[l];
+                }
+            }
+            for (int l = 0; l < lanes; ++l)
+            {
+                E_up[l]   = -(field[l] + pairs[l]);
+                E_down[l] = -(-field[l] + pairs[l]);
+                if constexpr (KTerms)
+                {
+                    E_up[l] -= K[k_up[l]];
+                    E_down[l] -= K[nspins - k_up[l]];
+                }
+            }
+        }
+
+        // (2) weights relative to the block's largest one: the lowest supported energy
+#pragma omp simd
+        for (int l = 0; l < lanes; ++l)
+        {
+            y_up[l]   = 1.0f - omq_f * beta_f * E_up[l];
+            y_down[l] = 1.0f - omq_f * beta_f * E_down[l];
+        }
+        float E_ref   = std::numeric_limits<float>::max();
+        uint64_t supp = 0;
+        for (int l = 0; l < n_valid; ++l)
+        {
+            if (Boltzmann || y_up[l] > 0.0f)
+                E_ref = std::min(E_ref, E_up[l]);
+            if (Boltzmann || y_down[l] > 0.0f)
+                E_ref = std::min(E_ref, E_down[l]);
+            supp += (y_up[l] > 0.0f) + (y_down[l] > 0.0f);
+        }
+        acc.n_states += 2 * static_cast<uint64_t>(n_valid);
+        acc.n_supp += supp;
+
+        const bool has_weight = (E_ref != std::numeric_limits<float>::max());
+        const double P_ref    = has_weight ? utils::exp_q(-beta * E_ref, q) : 0.0;
+        const float y_ref     = 1.0f - omq_f * beta_f * E_ref;
+        // exp_q of the shifted argument is the weight ratio: w = exp(-beta (E - E_ref)) for
+        // q = 1, and w = exp_q((y/y_ref - 1)/(1-q)) = (y/y_ref)^(1/(1-q)), or 0 if y <= 0
+        if constexpr (Boltzmann)
+        {
+#pragma omp simd
+            for (int l = 0; l < lanes; ++l)
+            {
+                w_up[l]   = -beta_f * (E_up[l] - E_ref);
+                w_down[l] = -beta_f * (E_down[l] - E_ref);
+            }
+        }
+        else
+        {
+#pragma omp simd
+            for (int l = 0; l < lanes; ++l)
+            {
+                w_up[l]   = (y_up[l] / y_ref - 1.0f) * inv_omq_f;
+                w_down[l] = (y_down[l] / y_ref - 1.0f) * inv_omq_f;
+            }
+        }
+        utils::exp_q_batch(w_up, w_up, lanes, q_f);
+        utils::exp_q_batch(w_down, w_down, lanes, q_f);
+        for (int l = n_valid; l < lanes; ++l)
+            w_up[l] = w_down[l] = 0.0f;
+
+        if constexpr (Triplets)
+        {
+            for (int l = 0; l < n_valid; ++l)
+            {
+                int bin_up   = static_cast<int>(std::round(E_up[l] / params.energy_bin));
+                int bin_down = static_cast<int>(std::round(E_down[l] / params.energy_bin));
+                acc.GE[bin_up] += 1.0;
+                acc.GE[bin_down] += 1.0;
+                acc.PE[bin_up] += P_ref * w_up[l];
+                acc.PE[bin_down] += P_ref * w_down[l];
+            }
+        }
+        if (!has_weight)
+            continue;
+
+        if (P_ref > acc.max_weight)
+        {
+            acc.max_weight        = P_ref;
+            acc.max_bracket       = 1.0 - one_minus_q * beta * E_ref;
+            acc.max_weight_energy = E_ref;
+        }
+
+        // (3) scalar sums, each reduced over the lanes and added in double
+#pragma omp simd
+        for (int l = 0; l < lanes; ++l)
+        {
+            w_sum[l]  = w_up[l] + w_down[l]; // weight of even observables
+            w_diff[l] = w_up[l] - w_down[l]; // weight of odd observables
+            tmp[l]    = w_sum[l];
+        }
+        acc.Z += P_ref * lane_sum(tmp);
+
+#pragma omp simd
+        for (int l = 0; l < lanes; ++l)
+            tmp[l] = w_up[l] * E_up[l] + w_down[l] * E_down[l];
+        acc.energy += P_ref * lane_sum(tmp);
+
+#pragma omp simd
+        for (int l = 0; l < lanes; ++l)
+            tmp[l] = w_up[l] * E_up[l] * E_up[l] + w_down[l] * E_down[l] * E_down[l];
+        acc.energy_sq += P_ref * lane_sum(tmp);
+
+#pragma omp simd
+        for (int l = 0; l < lanes; ++l)
+            tmp[l] = w_diff[l] * (2.0f * k_up[l] - nspins) * inv_n;
+        acc.magnetization += P_ref * lane_sum(tmp);
+
+        for (int l = 0; l < n_valid; ++l)
+        {
+            acc.pK(k_up[l]) += P_ref * w_up[l];
+            acc.pK(nspins - k_up[l]) += P_ref * w_down[l];
+        }
+
+        // (4) moments
+        int idx = 0;
+        for (int i = 0; i < nspins; ++i)
+        {
+            const float *s_i = &s[static_cast<size_t>(i) * lanes];
+#pragma omp simd
+            for (int l = 0; l < lanes; ++l)
+                tmp[l] = w_diff[l] * s_i[l];
+            acc.m1(i) += P_ref * lane_sum(tmp);
+
+            for (int j = i + 1; j < nspins; ++j)
+            {
+                const float *s_j = &s[static_cast<size_t>(j) * lanes];
+#pragma omp simd
+                for (int l = 0; l < lanes; ++l)
+                    tmp[l] = w_sum[l] * s_i[l] * s_j[l];
+                acc.m2(idx++) += P_ref * lane_sum(tmp);
+            }
+        }
+
+        if constexpr (Triplets)
+        {
+            idx = 0;
+            for (int i = 0; i < nspins - 2; ++i)
+            {
+                const float *s_i = &s[static_cast<size_t>(i) * lanes];
+                for (int j = i + 1; j < nspins - 1; ++j)
+                {
+                    const float *s_j = &s[static_cast<size_t>(j) * lanes];
+                    for (int k = j + 1; k < nspins; ++k)
+                    {
+                        const float *s_k = &s[static_cast<size_t>(k) * lanes];
+#pragma omp simd
+                        for (int l = 0; l < lanes; ++l)
+                            tmp[l] = w_diff[l] * s_i[l] * s_j[l] * s_k[l];
+                        acc.m3(idx++) += P_ref * lane_sum(tmp);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Instantiation of enumerateChunkFloat for a combination of model flags.
+ */
+FullEnsembleTrainer::ChunkKernel FullEnsembleTrainer::chunkKernelFloat(bool k_terms,
+                                                                       bool boltzmann,
+                                                                       bool triplets)
+{
+    static constexpr ChunkKernel kernels[8] = {
+        &FullEnsembleTrainer::enumerateChunkFloat<false, false, false>,
+        &FullEnsembleTrainer::enumerateChunkFloat<false, false, true>,
+        &FullEnsembleTrainer::enumerateChunkFloat<false, true, false>,
+        &FullEnsembleTrainer::enumerateChunkFloat<false, true, true>,
+        &FullEnsembleTrainer::enumerateChunkFloat<true, false, false>,
+        &FullEnsembleTrainer::enumerateChunkFloat<true, false, true>,
+        &FullEnsembleTrainer::enumerateChunkFloat<true, true, false>,
+        &FullEnsembleTrainer::enumerateChunkFloat<true, true, true>,
+    };
+    return kernels[4 * k_terms + 2 * boltzmann + triplets];
+}
+
+/**
+ * @brief Largest deviation of the single-precision averages from the double ones.
+ *
+ * Compares the normalized m1, m2, m3 and p(k) (absolute), and <E>, <E^2> (relative to
+ * max(1, |value|)), of two accumulators of the same states.
+ */
+double FullEnsembleTrainer::singlePrecisionDeviation(const EnsembleAccumulator &reference,
+                                                     const EnsembleAccumulator &single) const
+{
+    auto logger = getLogger();
+
+    auto max_dev = [](const arma::Col<double> &a, double Za, const arma::Col<double> &b,
+                      double Zb)
+    { return a.is_empty() ? 0.0 : arma::max(arma::abs(a / Za - b / Zb)); };
+    auto rel_dev = [](double a, double b) { return std::abs(a - b) / std::max(1.0, std::abs(a)); };
+
+    const double Zr = reference.Z, Zs = single.Z;
+    double dev_m1   = max_dev(reference.m1, Zr, single.m1, Zs);
+    double dev_m2   = max_dev(reference.m2, Zr, single.m2, Zs);
+    double dev_m3   = max_dev(reference.m3, Zr, single.m3, Zs);
+    double dev_pK   = max_dev(reference.pK, Zr, single.pK, Zs);
+    double dev_E    = rel_dev(reference.energy / Zr, single.energy / Zs);
+    double dev_E2   = rel_dev(reference.energy_sq / Zr, single.energy_sq / Zs);
+
+    double dev = std::max({dev_m1, dev_m2, dev_m3, dev_pK, dev_E, dev_E2});
+    logger->info("[singlePrecisionDeviation] m1 {:.2e} m2 {:.2e} m3 {:.2e} pK {:.2e} E {:.2e} "
+                 "E2 {:.2e} | Z ratio - 1 = {:.2e}",
+                 dev_m1, dev_m2, dev_m3, dev_pK, dev_E, dev_E2, Zs / Zr - 1.0);
+    if (dev > single_precision_tolerance)
+        logger->warn("[singlePrecisionDeviation] float kernel deviates by {:.2e} > {:.0e}", dev,
+                     single_precision_tolerance);
+    return dev;
+}
@@ -47,6 +47,7 @@ void FullEnsembleTrainer::train()
         if (iter % params.save_checkpoint == 0)
         {
             saveModel(params.file_checkpoint, false); 
+            clearEnumerationCheckpoints(); // the checkpoint no longer needs them
         }
     }
 
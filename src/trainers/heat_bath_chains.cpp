@@ -0,0 +1,184 @@
+#include "trainers/heat_bath_chain.hpp"
+#include "trainers/heat_bath_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <omp.h> // OpenMP
+#include <vector>
+
+/**
+ * @brief Splits the total_number_samples samples over the chains.
+ *
+ * params.hb_chains < 0 keeps number_repetitions chains of num_samples each, 0 runs one chain
+ * per OpenMP thread and n > 0 runs n chains. The remainder goes to the first chains, one
+ * sample each, so the chains differ by at most one sample; each needs its own equilibration,
+ * which is why fewer and longer chains cost less in total.
+ */
+void HeatBathTrainer::scheduleChains()
+{
+    size_t n_chains = params.number_repetitions;
+    if (params.hb_chains == 0)
+        n_chains = omp_get_max_threads();
+    else if (params.hb_chains > 0)
+        n_chains = params.hb_chains;
+    n_chains = std::clamp<size_t>(n_chains, 1, std::max<size_t>(total_number_samples, 1));
+
+    chain_samples.assign(n_chains, total_number_samples / n_chains);
+    for (size_t n = 0; n < total_number_samples % n_chains; ++n)
+        ++chain_samples[n];
+    chain_offsets.assign(n_chains, 0);
+    for (size_t n = 1; n < n_chains; ++n)
+        chain_offsets[n] = chain_offsets[n - 1] + chain_samples[n - 1];
+
+    getLogger()->debug("[scheduleChains] {} samples in {} chains of {} to {}",
+                       total_number_samples, n_chains, chain_samples.back(),
+                       chain_samples.front());
+}
+
+/**
+ * @brief Sets where the chains of this call start and how long they equilibrate.
+ *
+ * Persistent chains (params.persistent_chains) sampled at the same beta continue after
+ * step_reequilibration sweeps. Otherwise the chains are new: from all spins -1 with the
+ * streams utils::Philox(mc_seed, n) after step_equilibration sweeps, or, with
+ * params.fork_seed_chains, forked from equilibrated seeds after step_decorrelation.
+ */
+void HeatBathTrainer::prepareChains(double beta)
+{
+    auto logger           = getLogger();
+    const size_t n_chains = chain_samples.size();
+
+    n_equilibration = params.step_equilibration;
+    stored_chains   = false;
+    forked_chains   = false;
+
+    if (params.persistent_chains && chain_states.size() == n_chains && chain_beta == beta)
+    {
+        logger->debug("[prepareChains] resuming {} chains at beta = {}", n_chains, beta);
+        n_equilibration = params.step_reequilibration;
+        stored_chains   = true;
+        return;
+    }
+    if (!params.persistent_chains && params.fork_seed_chains == 0)
+        return;
+
+    chain_states.assign(n_chains, utils::SpinState(core.nspins, -1));
+    chain_rngs.clear();
+    for (size_t n = 0; n < n_chains; ++n)
+        chain_rngs.emplace_back(mc_seed, n);
+    chain_beta    = beta;
+    stored_chains = true;
+
+    if (params.fork_seed_chains > 0)
+    {
+        core.syncCouplings(); // the seeds update their fields from rows of J_dense
+        utils::withSpinCount(core.nspins,
+                             [&](auto size)
+                             {
+                                 constexpr int N = decltype(size)::value;
+                                 if (params.k_pairwise)
+                                     forkChains<N, true>(beta);
+                                 else
+                                     forkChains<N, false>(beta);
+                             });
+        n_equilibration = params.step_decorrelation;
+        forked_chains   = true;
+        fork_states.resize(n_chains);
+    }
+}
+
+/**
+ * @brief Equilibrates params.fork_seed_chains seed chains and starts every chain from one.
+ *
+ * Seed s runs step_equilibration sweeps from all spins -1 with its own generator,
+ * utils::Philox(mc_seed, n_chains + s), a stream none of the chains uses. Chain n
+ * then starts from seed n % n_seeds with its usual stream n, so siblings
+ * diverge from the first sweep, and decorrelates for step_decorrelation sweeps. The
+ * equilibration work drops from n_chains to n_seeds times step_equilibration.
+ */
+template <int N, bool KPairwise> void HeatBathTrainer::forkChains(double beta)
+{
+    const size_t n_chains = chain_samples.size();
+    const size_t n_seeds  = std::min(params.fork_seed_chains, n_chains);
+    std::vector<utils::SpinState> seeds(n_seeds);
+
+#pragma omp parallel
+    {
+        HeatBathChain<N, KPairwise> chain(core, beta);
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t s = 0; s < n_seeds; ++s)
+        {
+            chain.start(utils::SpinState(core.nspins, -1), utils::Philox(mc_seed, n_chains + s));
+            for (size_t sweep = 0; sweep < params.step_equilibration; ++sweep)
+                chain.sweep();
+            seeds[s] = chain.s;
+        }
+    }
+
+    for (size_t n = 0; n < n_chains; ++n)
+        chain_states[n] = seeds[n % n_seeds];
+    getLogger()->debug("[forkChains] {} chains forked from {} seeds", n_chains, n_seeds);
+}
+
+/**
+ * @brief How far the forked chains decorrelated from their siblings.
+ *
+ * The overlap q_ab = (1/n) sum_i s_i^a s_i^b of the first samples of two chains forked from
+ * the same seed starts at 1 and decays to that of independent samples. Chains forked from
+ * different seeds are independent, so their mean overlap is the reference; with a single
+ * seed it is the expectation (1/n) sum_i <s_i>^2 from the averages. A sibling overlap above
+ * the reference by more than three standard errors (counted per chain, since every chain
+ * enters many pairs) means step_decorrelation is too short for the model.
+ */
+void HeatBathTrainer::measureForkOverlap()
+{
+    auto logger           = getLogger();
+    const int nspins      = core.nspins;
+    const size_t n_chains = chain_samples.size();
+    const size_t n_seeds  = std::min(params.fork_seed_chains, n_chains);
+
+    double sibling_sum = 0.0, sibling_sq = 0.0, other_sum = 0.0;
+    size_t n_siblings = 0, n_others = 0;
+    for (size_t a = 0; a < n_chains; ++a)
+        for (size_t b = a + 1; b < n_chains; ++b)
+        {
+            int dot = 0;
+            for (int i = 0; i < nspins; ++i)
+                dot += fork_states[a](i) * fork_states[b](i);
+            const double q = static_cast<double>(dot) / nspins;
+            if (a % n_seeds == b % n_seeds)
+            {
+                sibling_sum += q;
+                sibling_sq += q * q;
+                ++n_siblings;
+            }
+            else
+            {
+                other_sum += q;
+                ++n_others;
+            }
+        }
+
+    independent_overlap = (n_others > 0) ? other_sum / n_others
+                                         : arma::dot(m1_model, m1_model) / nspins;
+    if (n_siblings == 0)
+    {
+        fork_overlap       = std::numeric_limits<double>::quiet_NaN();
+        fork_overlap_error = std::numeric_limits<double>::quiet_NaN();
+        logger->debug("[forkChains] one chain per seed, no siblings to compare");
+        return;
+    }
+
+    fork_overlap          = sibling_sum / n_siblings;
+    const double variance = std::max(0.0, sibling_sq / n_siblings - fork_overlap * fork_overlap);
+    fork_overlap_error    = std::sqrt(variance / n_chains);
+    logger->info("[forkChains] overlap of forked siblings {:.4f} +- {:.4f}, of independent "
+                 "chains {:.4f}",
+                 fork_overlap, fork_overlap_error, independent_overlap);
+    if (fork_overlap - independent_overlap > 3.0 * fork_overlap_error)
+        logger->warn("[forkChains] the forked chains are still correlated after {} sweeps; "
+                     "increase step_decorrelation",
+                     params.step_decorrelation);
+}
@@ -3,7 +3,6 @@
 #include "utils/utilities.hpp"
 #include <armadillo>
 #include <cmath>
-#include <random>
 
 // Perform Heat-Bath sampling and compute model averages
 void HeatBathTrainer::computeModelAverages1(double beta, bool triplets)
@@ -29,17 +28,13 @@ void HeatBathTrainer::computeModelAverages1(double beta, bool triplets)
     // k-pairwise
     pK_model.zeros(nspins + 1);
 
-    // Random number generator setup
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-
-    arma::Col<int> s(nspins);
+    utils::SpinState s(nspins);
 
     replicas.fill(-1); // Initialize replicas to -1
     int n_samples_collected = 0;
     for (size_t n = 0; n < params.number_repetitions; ++n)
     {
-        // std::mt19937 rng(std::random_device{}());
-        std::mt19937 rng(mc_seed + n); // each repetition has a determined  seed
+        utils::Philox rng(mc_seed, n); // each repetition has its own stream
         s.fill(-1);
 
         for (size_t sweep = 0; sweep < params.step_equilibration; ++sweep)
@@ -60,8 +55,8 @@ void HeatBathTrainer::computeModelAverages1(double beta, bool triplets)
                 // double prob_plus = exp_plus / (exp_plus + exp_minus);
                 double prob_plus = 1.0 / (1.0 + std::exp(-2.0 * beta * h_i));
 
-                double r = dist(rng);
-                s(i)     = (r < prob_plus) ? 1 : -1;
+                double r = rng.uniform();
+                s.set(i, (r < prob_plus) ? 1 : -1);
             }
         }
 
@@ -87,8 +82,8 @@ void HeatBathTrainer::computeModelAverages1(double beta, bool triplets)
                 // double prob_plus = exp_plus / (exp_plus + exp_minus);
                 double prob_plus = 1.0 / (1.0 + std::exp(-2.0 * beta * h_i));
 
-                double r = dist(rng);
-                s(i)     = (r < prob_plus) ? 1 : -1;
+                double r = rng.uniform();
+                s.set(i, (r < prob_plus) ? 1 : -1);
             }
 
             // Every sampleInterval sweeps, record the current configuration
@@ -97,7 +92,7 @@ void HeatBathTrainer::computeModelAverages1(double beta, bool triplets)
                 double E = energyAllPairs(s);
                 avg_energy += E;
                 avg_energy_sq += E * E;
-                avg_magnetization += arma::mean(arma::conv_to<arma::vec>::from(s));
+                avg_magnetization += s.magnetization();
 
                 for (size_t i = 0; i < nspins; ++i)
                 {
@@ -126,11 +121,11 @@ void HeatBathTrainer::computeModelAverages1(double beta, bool triplets)
                             }
                         }
                     }
-                    replicas.row(n_samples_collected) = s.t();
+                    replicas.set_row(n_samples_collected, s);
                 }
 
                 // k-pairwise
-                int k = static_cast<int>(arma::sum(s + 1) / 2);
+                int k = s.numUp();
                 pK_model(k) += 1.0;
 
                 n_collected_rep++;
@@ -0,0 +1,280 @@
+#include "trainers/heat_bath_trainer.hpp"
+#include "utils/get_logger.hpp"
+#include "utils/vector_math.hpp"
+#include <algorithm>
+#include <armadillo>
+#include <cmath>
+#include <omp.h> // OpenMP
+#include <vector>
+
+/**
+ * @brief Heat-bath chains advanced Lanes at a time, one vector operation across the chains.
+ *
+ * The chains of a block are stored spin-major (structure of arrays): spins[i * Lanes + l] and
+ * field[i * Lanes + l] are s_i and f_i of chain l. The update of spin i compares one vector
+ * of fields with one vector of thresholds, and when any chain flips, every field of the block
+ * takes delta[l] J_ij, with delta[l] = 0 for the chains that kept s_i. The sweeps then run
+ * without the data-dependent branch and the scattered field updates of the scalar sampler.
+ *
+ * Chain c still draws from its own utils::Philox(mc_seed, c), in the order of
+ * sampleModelAverages (a sweep's uniforms and their logits up front without k-pairwise, one
+ * uniform per spin with it), and its fields and energy follow the same operations. Every
+ * chain, with its moments and replicas, is therefore the one the scalar sampler produces;
+ * only the order in which the energies are summed differs. A block runs until its longest
+ * chain has its chain_samples; the shorter chains and the spare lanes of the last block keep
+ * sweeping without being recorded.
+ *
+ * @tparam Lanes      Chains per block (params.hb_lanes).
+ * @tparam KPairwise  Updates include the K[k] terms (params.k_pairwise).
+ * @tparam Triplets   Third-order moments and the replicas they are computed from.
+ */
+template <int Lanes, bool KPairwise, bool Triplets>
+void HeatBathTrainer::sampleReplicaLanes(double beta)
+{
+    auto logger         = getLogger();
+    const size_t nspins = core.nspins;
+    const size_t nedges = core.nedges;
+
+    core.syncCouplings();
+    const auto &h       = core.h;
+    const auto &K       = core.K;
+    const auto &J_dense = core.J_dense;
+    const auto &kernels = core.kernels();
+
+    // the chains start with the fields and energy of the scalar sampler
+    const auto dense_field = utils::withSpinCount(
+        nspins, [](auto size) { return &utils::denseField<decltype(size)::value, double>; });
+    const utils::SpinState all_down(nspins, -1);
+
+    m1_model.zeros(nspins);
+    m2_model.zeros(nedges);
+    if constexpr (Triplets)
+        m3_model.zeros(ntriplets);
+    pK_model.zeros(nspins + 1);
+
+    avg_energy        = 0.0;
+    avg_energy_sq     = 0.0;
+    avg_magnetization = 0.0;
+
+    const size_t n_chains      = chain_samples.size();
+    const size_t n_blocks      = (n_chains + Lanes - 1) / Lanes;
+    size_t global_sample_count = 0; // shared across threads
+
+#pragma omp parallel
+    {
+        arma::Col<double> local_m1_model(nspins, arma::fill::zeros);
+        arma::Col<double> local_m2_model(nedges, arma::fill::zeros);
+        arma::Col<double> local_m3_model;
+        if constexpr (Triplets)
+            local_m3_model.set_size(ntriplets), local_m3_model.zeros();
+        arma::Col<double> local_pK_model(nspins + 1, arma::fill::zeros);
+
+        double local_avg_energy        = 0.0;
+        double local_avg_energy_sq     = 0.0;
+        double local_avg_magnetization = 0.0;
+
+        size_t local_sample_count = 0;
+
+        // the block: one generator per chain, spins and fields spin-major
+        std::vector<utils::Philox> rngs(Lanes);
+        std::vector<double> lane_r(nspins); // one chain's uniforms of a sweep
+        std::vector<int8_t> spins(nspins * Lanes);
+        std::vector<double> field(nspins * Lanes);
+        std::vector<double> logit_r(nspins * Lanes); // the sweep's logits, spin-major
+        double E_pairs[Lanes];
+        int ki[Lanes];
+        utils::SpinState lane_state(nspins); // one chain, for the moment kernels
+
+        // Without k-pairwise, r < 1 / (1 + exp(-2 beta h_i)) <=> 2 beta h_i > log(r / (1-r)),
+        // as in sampleModelAverages: each chain draws its sweep's uniforms from its own
+        // stream, and the logits of the block are taken in one vectorized call.
+        auto draw_logits = [&]()
+        {
+            for (int l = 0; l < Lanes; ++l)
+            {
+                rngs[l].uniforms(lane_r.data(), nspins);
+                for (size_t i = 0; i < nspins; ++i)
+                    logit_r[i * Lanes + l] = lane_r[i] / (1.0 - lane_r[i]);
+            }
+            utils::log_q_batch(logit_r.data(), logit_r.data(), nspins * Lanes, 1.0);
+        };
+
+        auto heat_bath_sweep = [&]()
+        {
+            if constexpr (!KPairwise)
+                draw_logits();
+            for (size_t i = 0; i < nspins; ++i)
+            {
+                int8_t *s_i       = &spins[i * Lanes];
+                const double *f_i = &field[i * Lanes];
+                alignas(64) double delta[Lanes];
+                int flips = 0;
+                if constexpr (KPairwise)
+                {
+                    for (int l = 0; l < Lanes; ++l)
+                    {
+                        // as HeatBathChain: up spins with s_i = +1 and with s_i = -1
+                        const int k_plus   = ki[l] + (s_i[l] == -1);
+                        const int k_minus  = ki[l] - (s_i[l] == 1);
+                        const double logit = 2.0 * f_i[l] + K(k_plus) - K(k_minus);
+                        double prob_plus   = 1.0 / (1.0 + std::exp(-beta * logit));
+                        double r           = rngs[l].uniform();
+                        delta[l]           = ((r < prob_plus) ? 1.0 : -1.0) - s_i[l];
+                    }
+                }
+                else
+                {
+                    const double *logit_i = &logit_r[i * Lanes];
+#pragma omp simd
+                    for (int l = 0; l < Lanes; ++l)
+                        delta[l] = ((2.0 * beta * f_i[l] > logit_i[l]) ? 1.0 : -1.0) - s_i[l];
+                }
+
+#pragma omp simd reduction(+ : flips)
+                for (int l = 0; l < Lanes; ++l)
+                {
+                    E_pairs[l] -= delta[l] * f_i[l];
+                    ki[l] += static_cast<int>(delta[l]) / 2;
+                    s_i[l] = static_cast<int8_t>(s_i[l] + static_cast<int>(delta[l]));
+                    flips += (delta[l] != 0.0);
+                }
+                if (flips == 0)
+                    continue;
+
+                // f_j += delta J_ij in every chain; J_ii = 0 keeps f_i. A few flips are
+                // cheaper one chain at a time.
+                const double *J_i = J_dense.row(i);
+                if (4 * flips <= Lanes)
+                {
+                    for (int l = 0; l < Lanes; ++l)
+                        if (delta[l] != 0.0)
+                            for (size_t j = 0; j < nspins; ++j)
+                                field[j * Lanes + l] += delta[l] * J_i[j];
+                    continue;
+                }
+                for (size_t j = 0; j < nspins; ++j)
+                {
+                    const double J_ij = J_i[j];
+                    double *f_j       = &field[j * Lanes];
+#pragma omp simd
+                    for (int l = 0; l < Lanes; ++l)
+                        f_j[l] += delta[l] * J_ij;
+                }
+            }
+        };
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t b = 0; b < n_blocks; ++b)
+        {
+            const size_t first = b * Lanes;
+            const int active   = static_cast<int>(std::min<size_t>(Lanes, n_chains - first));
+            // the first chains of the schedule are the longest
+            const size_t block_samples = chain_samples[first];
+            // a new chain starts from all spins -1, a stored one (persistent or forked) from
+            // its state; the spare lanes run new chains
+            for (int l = 0; l < Lanes; ++l)
+            {
+                const bool stored         = stored_chains && l < active;
+                const utils::SpinState &s = stored ? chain_states[first + l] : all_down;
+                if (stored)
+                    rngs[l] = chain_rngs[first + l];
+                else
+                    rngs[l] = utils::Philox(mc_seed, first + l);
+
+                for (size_t i = 0; i < nspins; ++i)
+                {
+                    spins[i * Lanes + l] = static_cast<int8_t>(s(i));
+                    field[i * Lanes + l] = dense_field(h(i), J_dense.row(i), s.data(), nspins);
+                }
+                E_pairs[l] = kernels.pair_energy(h.memptr(), core.J.memptr(), s.data(), nspins);
+                ki[l]      = s.numUp();
+            }
+
+            for (size_t sweep = 0; sweep < n_equilibration; ++sweep)
+                heat_bath_sweep();
+
+            // chain l's samples go to its rows from chain_offsets[first + l], in the order of
+            // the scalar sampler
+            size_t n_collected = 0;
+            size_t sweep       = 0;
+            while (n_collected < block_samples)
+            {
+                heat_bath_sweep();
+
+                if ((sweep % params.step_correlation) == 0)
+                {
+                    for (int l = 0; l < active; ++l)
+                    {
+                        const size_t c = first + l;
+                        if (n_collected >= chain_samples[c])
+                            continue;
+                        double E = E_pairs[l] - K(ki[l]);
+                        local_avg_energy += E;
+                        local_avg_energy_sq += E * E;
+                        local_avg_magnetization += (2.0 * ki[l] - double(nspins)) / nspins;
+                        local_pK_model(ki[l]) += 1.0;
+
+                        for (size_t i = 0; i < nspins; ++i)
+                            lane_state.set(i, spins[i * Lanes + l]);
+                        kernels.add_moments(1.0, 1.0, lane_state.data(),
+                                            local_m1_model.memptr(), local_m2_model.memptr(),
+                                            nspins);
+                        if (forked_chains && n_collected == 0)
+                            fork_states[c] = lane_state;
+                        if constexpr (Triplets)
+                        {
+                            kernels.add_triplets(1.0, lane_state.data(),
+                                                 local_m3_model.memptr(), nspins);
+                            replicas.set_row(chain_offsets[c] + n_collected, lane_state);
+                        }
+                        ++local_sample_count;
+
+                        // a persistent chain stops where the scalar sampler stops it
+                        if (params.persistent_chains && n_collected + 1 == chain_samples[c])
+                        {
+                            chain_states[c] = lane_state;
+                            chain_rngs[c]   = rngs[l];
+                        }
+                    }
+                    ++n_collected;
+                }
+                ++sweep;
+            }
+        }
+
+#pragma omp critical
+        {
+            logger->debug("thread: {} local_sample_count = {}", omp_get_thread_num(),
+                          local_sample_count);
+            global_sample_count += local_sample_count;
+
+            avg_energy += local_avg_energy;
+            avg_energy_sq += local_avg_energy_sq;
+            avg_magnetization += local_avg_magnetization;
+            m1_model += local_m1_model;
+            m2_model += local_m2_model;
+            if constexpr (Triplets)
+                m3_model += local_m3_model;
+            pK_model += local_pK_model;
+        }
+    } // End of parallel block
+
+    avg_energy /= static_cast<double>(global_sample_count);
+    avg_energy_sq /= static_cast<double>(global_sample_count);
+    avg_magnetization /= static_cast<double>(global_sample_count);
+
+    m1_model /= static_cast<double>(global_sample_count);
+    m2_model /= static_cast<double>(global_sample_count);
+    if constexpr (Triplets)
+        m3_model /= static_cast<double>(global_sample_count);
+    pK_model /= static_cast<double>(global_sample_count);
+}
+
+template void HeatBathTrainer::sampleReplicaLanes<8, false, false>(double);
+template void HeatBathTrainer::sampleReplicaLanes<8, false, true>(double);
+template void HeatBathTrainer::sampleReplicaLanes<8, true, false>(double);
+template void HeatBathTrainer::sampleReplicaLanes<8, true, true>(double);
+template void HeatBathTrainer::sampleReplicaLanes<16, false, false>(double);
+template void HeatBathTrainer::sampleReplicaLanes<16, false, true>(double);
+template void HeatBathTrainer::sampleReplicaLanes<16, true, false>(double);
+template void HeatBathTrainer::sampleReplicaLanes<16, true, true>(double);
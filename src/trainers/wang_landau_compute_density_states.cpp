@@ -6,16 +6,14 @@ void WangLandauTrainer::computeDensityOfStates()
 {
     auto logger = getLogger();
 
-    auto &h    = core.h;
-    auto &J    = core.J;
+    core.syncCouplings(); // for flippedEnergy
     int nspins = core.nspins;
 
     // RNG for spin updates
 
-    std::mt19937 rng(1); // you have two RNGs declared: keep only this one or the next one
-    // std::mt19937 rng(std::random_device{}()); // uncomment this for random seed per run
+    utils::Philox rng(1, 0); // a fixed stream: runs are reproducible
 
-    arma::Col<int> s = arma::ones<arma::Col<int>>(nspins); // initial state: all spins up
+    utils::SpinState s(nspins, 1); // initial state: all spins up
 
     // log_g_E: estimated log density of states g(E), H: histogram of visits to energy bins
 
@@ -23,8 +21,10 @@ void WangLandauTrainer::computeDensityOfStates()
     double E_real = energyAllPairs(s); // compute energy of current config
     int E_bin = static_cast<int>(std::round(E_real / params.energy_bin)); // assign energy to bin
 
-    log_g_E.clear();
-    H.clear();
+    // every energy bin the walk can reach, from |E| <= sum |h| + sum |J| + max |K|
+    const int max_bin = core.energyBinBound(params.energy_bin);
+    log_g_E.reset(-max_bin, max_bin);
+    H.reset(-max_bin, max_bin);
 
     logger->debug("[computeDensityOfStates] Wang-Landau started computing the DOS");
     size_t wl_iter = 0;
@@ -33,13 +33,17 @@ void WangLandauTrainer::computeDensityOfStates()
         ++wl_iter;
         H.clear(); // reset histogram for new round of sampling
 
+        // flippedEnergy accumulates rounding over the proposals: start each round exact
+        E_real = energyAllPairs(s);
+        E_bin  = static_cast<int>(std::round(E_real / params.energy_bin));
+
         // Main Wang-Landau loop: perform a random walk
         for (size_t sweep = 0; sweep < params.step_equilibration; ++sweep)
         {
-            arma::Col<int> s_new = s;
-            flip_random_spin(s_new, rng); // propose a single-spin flip
+            // propose a single-spin flip in place; a rejected move flips it back
+            int i_flip = flip_random_spin(s, rng);
 
-            double E_trial  = energyAllPairs(s_new);
+            double E_trial  = flippedEnergy(s, i_flip, E_real);
             int E_trial_bin = static_cast<int>(std::round(E_trial / params.energy_bin));
 
             // Read log_g_E values for current and proposed energies
@@ -49,15 +53,18 @@ void WangLandauTrainer::computeDensityOfStates()
 
             // Acceptance probability based on log density of states
             double p = std::exp(ln_g_E - ln_g_E_trial);
-            auto r   = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            auto r   = rng.uniform();
 
             if (r < std::min(1.0, p))
             {
                 // Accept the move
-                s      = s_new;
                 E_real = E_trial;
                 E_bin  = E_trial_bin;
             }
+            else
+            {
+                s.flip(i_flip);
+            }
 
             // Update log_g_E(E) and histogram H(E)
             log_g_E[E_bin] += log_f;
@@ -97,16 +104,11 @@ void WangLandauTrainer::computeDensityOfStates()
     }
     else
     {
-        int min_E = std::numeric_limits<int>::max();
-        int max_E = std::numeric_limits<int>::min();
-
+        // bins are visited in ascending order
+        int min_E = (*log_g_E.begin()).first;
+        int max_E = min_E;
         for (const auto &[E, logg] : log_g_E)
-        {
-            if (E < min_E)
-                min_E = E;
-            if (E > max_E)
-                max_E = E;
-        }
+            max_E = E;
 
         logger->debug(
             "[computeDensityOfStates] wl_iter {:03d} | bins= {:03d} | E_min = {:5.2e} | E_max = {:5.2e}", iter,
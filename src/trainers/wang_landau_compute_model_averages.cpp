@@ -2,14 +2,13 @@
 #include "trainers/wang_landau_trainer.hpp"
 #include "utils/utilities.hpp"
 
-arma::Col<int> random_spin_config(int nspins, std::mt19937 &rng)
+utils::SpinState random_spin_config(int nspins, utils::Philox &rng)
 {
-    arma::Col<int> s(nspins);
-    std::uniform_int_distribution<int> dist(0, 1); // returns 0 or 1
+    utils::SpinState s(nspins);
 
     for (int i = 0; i < nspins; ++i)
     {
-        s(i) = dist(rng) == 0 ? -1 : 1;
+        s.set(i, rng.below(2) == 0 ? -1 : 1);
     }
 
     return s;
@@ -27,8 +26,7 @@ void WangLandauTrainer::computeModelAverages(double beta, bool triplets)
 {
     auto logger = getLogger();
 
-    auto &h    = core.h;
-    auto &J    = core.J;
+    core.syncCouplings(); // for flippedEnergy
     int nspins = core.nspins;
     int nedges = core.nedges;
 
@@ -46,10 +44,10 @@ void WangLandauTrainer::computeModelAverages(double beta, bool triplets)
     pK_model.zeros(nspins + 1);
 
     // RNG for spin updates
-    std::mt19937 rng(wg_seed);
+    utils::Philox rng(wg_seed, 0);
 
     // initial state: avoid all spins up or down
-    arma::Col<int> s = random_spin_config(nspins, rng);
+    utils::SpinState s = random_spin_config(nspins, rng);
 
     // computer the energy now, and which bin it belongs to
     double E  = energyAllPairs(s);
@@ -89,47 +87,46 @@ void WangLandauTrainer::computeModelAverages(double beta, bool triplets)
 
     while (samplesCollected < params.num_samples)
     {
-        arma::Col<int> s_trial = s;
-        flip_random_spin(s_trial, rng); // propose a single-spin flip
+        // propose a single-spin flip in place; a rejected move flips it back
+        int i_flip = flip_random_spin(s, rng);
 
-        double E_trial  = energyAllPairs(s_trial);
+        double E_trial  = flippedEnergy(s, i_flip, E);
         int E_trial_bin = static_cast<int>(std::round(E_trial / params.energy_bin));
 
-        // auto it_current = log_g_E.find(E_bin) reads log_g_E values for current and proposed
-        // energies Note: if not previously visited, default-initialized to 0.0 so avoid directly
-        // double ln_g_E       = log_g_E[E_bin];
-        // double ln_g_E_trial = log_g_E[E_trial_bin];
-        auto it_current = log_g_E.find(E_bin);
-        auto it_trial   = log_g_E.find(E_trial_bin);
-        if (it_current == log_g_E.end() || it_trial == log_g_E.end())
+        // reads log_g_E values for current and proposed energies. Note: bins never visited by
+        // computeDensityOfStates have no estimate, so moves into them are skipped
+        if (!log_g_E.contains(E_bin) || !log_g_E.contains(E_trial_bin))
+        {
+            s.flip(i_flip);
             continue;
+        }
 
-        double ln_g_E       = it_current->second;
-        double ln_g_E_trial = it_trial->second;
+        double ln_g_E       = log_g_E.at(E_bin);
+        double ln_g_E_trial = log_g_E.at(E_trial_bin);
 
         double p = std::exp(ln_g_E - ln_g_E_trial);
-        double r = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double r = rng.uniform();
 
         if (r < std::min(1.0, p))
         {
             n_accepted++;
-            s     = s_trial;
             E     = E_trial;
             E_bin = E_trial_bin;
         }
         else
         {
             n_rejected++;
+            s.flip(i_flip);
         }
 
         if (sweep % params.step_correlation == 0)
         {
             n_accepted                       = 0;
             n_rejected                       = 0;
-            double log_P_E                   = -beta * E - log_g_E[E_bin];
+            double log_P_E                   = -beta * E - log_g_E.at(E_bin);
             log_weights[samplesCollected]    = log_P_E;
             energies[samplesCollected]       = E;
-            magnetizations[samplesCollected] = arma::mean(arma::conv_to<arma::vec>::from(s));
+            magnetizations[samplesCollected] = s.magnetization();
 
             for (size_t i = 0; i < nspins; ++i)
                 m1(i) = s(i);
@@ -146,28 +143,30 @@ void WangLandauTrainer::computeModelAverages(double beta, bool triplets)
             // Third moment (optional)
             if (triplets)
             {
-                arma::Col<double> m3(ntriplets);
                 idx = 0;
                 for (size_t i = 0; i < nspins - 2; ++i)
                     for (size_t j = i + 1; j < nspins - 1; ++j)
                         for (size_t k = j + 1; k < nspins; ++k)
                             m3(idx++) = s(i) * s(j) * s(k);
                 m3_list[samplesCollected]      = m3;
-                replicas.row(samplesCollected) = s.t();
+                replicas.set_row(samplesCollected, s);
             }
 
             // k-pairwise
-            int k = static_cast<int>(arma::sum(s + 1) / 2);
+            int k = s.numUp();
             pK_list[samplesCollected][k] += 1;
 
-            logger->debug("[wl train] ...................................");
-            logger->debug("[wl train]  sweep {}  E: {} E_bin: {} p: {} r: {}", sweep, E, E_bin, p,
-                          r);
-            logger->debug("[wl train] s: {}", utils::colPrint<int>(s));
-            logger->debug("[wl train] sample {} n_accepted: {} n_rejected: {} ", samplesCollected,
-                          n_accepted, n_rejected);
-            logger->debug("[wl train] log_P_E: {}", log_P_E);
-            logger->debug("[wl train] ...................................");
+            if (logger->should_log(spdlog::level::debug))
+            {
+                logger->debug("[wl train] ...................................");
+                logger->debug("[wl train]  sweep {}  E: {} E_bin: {} p: {} r: {}", sweep, E, E_bin,
+                              p, r);
+                logger->debug("[wl train] s: {}", utils::colPrint(s));
+                logger->debug("[wl train] sample {} n_accepted: {} n_rejected: {} ",
+                              samplesCollected, n_accepted, n_rejected);
+                logger->debug("[wl train] log_P_E: {}", log_P_E);
+                logger->debug("[wl train] ...................................");
+            }
 
             ++samplesCollected;
         }
@@ -3,17 +3,36 @@
 /**
  * @brief Randomly flips a single spin in the spin vector.
  *
- * Selects a random index in the input column vector `s` and flips the spin at that index
- * (i.e., multiplies it by -1). Assumes spins are represented as integers (+1 or -1).
+ * Selects a random index in the spin state `s` and flips the spin at that index
+ * (i.e., multiplies it by -1).
  *
- * @param s   Reference to a column vector of spins (arma::Col<int>).
- * @param rng Reference to a random number generator (std::mt19937).
+ * @param s   Reference to the spin state (utils::SpinState).
+ * @param rng Reference to the walk's random number generator (utils::Philox).
+ * @return    Index of the flipped spin, so that a rejected move can be undone.
  */
-void WangLandauTrainer::flip_random_spin(arma::Col<int> &s, std::mt19937 &rng)
+int WangLandauTrainer::flip_random_spin(utils::SpinState &s, utils::Philox &rng)
 {
-    std::uniform_int_distribution<int> dist(0, s.n_elem - 1);
-    int i = dist(rng);
-    s(i) *= -1; // flip spin from +1 to -1 or vice versa
+    int i = rng.below(s.size());
+    s.flip(i); // flip spin from +1 to -1 or vice versa
+    return i;
+}
+
+/**
+ * @brief Energy of s after flip_random_spin flipped spin i, from the energy E before.
+ *
+ * Only the terms of spin i change: -2 s_i f_i with the local field f_i = h_i + sum_j J_ij s_j
+ * (one dot product with row i of the dense couplings, synced by the caller), and K[k] with
+ * k moved by s_i. O(n) instead of energyAllPairs' O(n^2).
+ *
+ * @param s  Spin state after the flip.
+ * @param i  Index of the flipped spin.
+ * @param E  Energy before the flip.
+ */
+double WangLandauTrainer::flippedEnergy(const utils::SpinState &s, int i, double E) const
+{
+    const int k      = s.numUp();
+    const double f_i = utils::denseField<0>(core.h(i), core.J_dense.row(i), s.data(), core.nspins);
+    return E - 2.0 * s(i) * f_i + core.K(k - s(i)) - core.K(k);
 }
 
 /**
@@ -27,12 +46,12 @@ void WangLandauTrainer::flip_random_spin(arma::Col<int> &s, std::mt19937 &rng)
  * @param flatness_threshold Threshold ratio (default is 0.8) to determine flatness.
  * @return true if the histogram is flat, false otherwise.
  */
-bool WangLandauTrainer::is_flat(const std::unordered_map<int, int> &H, 
+bool WangLandauTrainer::is_flat(const utils::DenseHistogram<int> &H, 
                                 double flatness_threshold)
 {
     int min_H = std::numeric_limits<int>::max();
     int max_H = 0;
-    for (auto &[E, count] : H)
+    for (const auto &[E, count] : H)
     {
         min_H = std::min(min_H, count);
         max_H = std::max(max_H, count);
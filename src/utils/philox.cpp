@@ -0,0 +1,68 @@
+#include "utils/philox.hpp"
+#include <cstdint>
+
+// one clone per instruction set, picked at load time (ifunc), as in vector_math.cpp
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__) && !defined(__clang__)
+#define MAXENT_TARGET_CLONES                                                                      \
+    __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define MAXENT_TARGET_CLONES
+#endif
+
+namespace
+{
+// (hi 2^32 + lo) / 2^64 rounded down to 53 bits, as philox_to_uniforms, with the conversions
+// from signed 32-bit integers that SSE/AVX have (unsigned 64-bit ones need AVX-512DQ); the
+// sum is exact
+inline __attribute__((always_inline)) double to_uniform(uint32_t hi, uint32_t lo)
+{
+    const double high = static_cast<double>(static_cast<int32_t>(hi ^ 0x80000000u)) + 0x1p31;
+    const double low  = static_cast<double>(static_cast<int32_t>(lo >> 11));
+    return high * 0x1p-32 + low * 0x1p-53;
+}
+} // namespace
+
+namespace utils
+{
+
+// The blocks are independent: the loop runs the rounds of philox4x32 for several counters
+// side by side, the 32x32 -> 64-bit products in vector multiplies (pmuludq). The rounds are
+// spelled out on scalars so that the compiler vectorizes the outer loop.
+MAXENT_TARGET_CLONES
+void philox_uniform_batch(uint64_t seed, uint64_t stream, uint64_t first_block, double *u,
+                          std::size_t n_blocks)
+{
+    constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    constexpr uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+    const uint32_t key0   = static_cast<uint32_t>(seed);
+    const uint32_t key1   = static_cast<uint32_t>(seed >> 32);
+    const uint32_t c2     = static_cast<uint32_t>(stream);
+    const uint32_t c3     = static_cast<uint32_t>(stream >> 32);
+
+#pragma omp simd
+    for (std::size_t j = 0; j < n_blocks; ++j)
+    {
+        const uint64_t b = first_block + j;
+        uint32_t x0 = static_cast<uint32_t>(b), x1 = static_cast<uint32_t>(b >> 32);
+        uint32_t x2 = c2, x3 = c3;
+        uint32_t k0 = key0, k1 = key1;
+#pragma GCC unroll 10
+        for (int round = 0; round < 10; ++round)
+        {
+            const uint64_t p0 = static_cast<uint64_t>(M0) * x0;
+            const uint64_t p1 = static_cast<uint64_t>(M1) * x2;
+            const uint32_t y0 = static_cast<uint32_t>(p1 >> 32) ^ x1 ^ k0;
+            const uint32_t y2 = static_cast<uint32_t>(p0 >> 32) ^ x3 ^ k1;
+            x1                = static_cast<uint32_t>(p1);
+            x3                = static_cast<uint32_t>(p0);
+            x0                = y0;
+            x2                = y2;
+            k0 += W0;
+            k1 += W1;
+        }
+        u[2 * j]     = to_uniform(x1, x0);
+        u[2 * j + 1] = to_uniform(x3, x2);
+    }
+}
+
+} // namespace utils
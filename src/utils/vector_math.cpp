@@ -0,0 +1,261 @@
+#include "utils/vector_math.hpp"
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+// one clone of every batch function per instruction set, picked at load time (ifunc)
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__) && !defined(__clang__)
+#define MAXENT_TARGET_CLONES                                                                      \
+    __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define MAXENT_TARGET_CLONES
+#endif
+
+#define MAXENT_INLINE inline __attribute__((always_inline))
+
+namespace
+{
+
+// ---------------------------------------------------------------------------------------
+// double
+// ---------------------------------------------------------------------------------------
+
+// exp(x): x = k ln2 + r with |r| <= ln2/2, exp(r) by its Taylor series to degree 13, and
+// 2^k applied as 2^(k/2) 2^(k - k/2) so that both factors are normal numbers
+MAXENT_INLINE double exp_kernel(double x)
+{
+    constexpr double log2e  = 1.44269504088896340736;
+    constexpr double ln2_hi = 6.93147180369123816490e-01;
+    constexpr double ln2_lo = 1.90821492927058770002e-10;
+    constexpr double shift  = 0x1.8p52; // adding it rounds to an integer in the low bits
+    constexpr double x_max  = 709.782712893383973096; // log(DBL_MAX)
+    constexpr double x_min  = -745.133219101941108420; // log of the smallest denormal
+
+    double xc = (x < x_min) ? x_min : x;
+    xc        = (xc > x_max) ? x_max : xc;
+    double kd = xc * log2e + shift;
+    int64_t k = static_cast<int64_t>(std::bit_cast<uint64_t>(kd) - std::bit_cast<uint64_t>(shift));
+    kd -= shift;
+    double r = (xc - kd * ln2_hi) - kd * ln2_lo;
+
+    double p = 1.0 / 6227020800.0;
+    p        = p * r + 1.0 / 479001600.0;
+    p        = p * r + 1.0 / 39916800.0;
+    p        = p * r + 1.0 / 3628800.0;
+    p        = p * r + 1.0 / 362880.0;
+    p        = p * r + 1.0 / 40320.0;
+    p        = p * r + 1.0 / 5040.0;
+    p        = p * r + 1.0 / 720.0;
+    p        = p * r + 1.0 / 120.0;
+    p        = p * r + 1.0 / 24.0;
+    p        = p * r + 1.0 / 6.0;
+    p        = p * r + 0.5;
+    p        = p * r + 1.0;
+    p        = p * r + 1.0;
+
+    // k/2 with a logical shift (no 64-bit arithmetic shift before AVX-512)
+    int64_t k1     = static_cast<int64_t>(static_cast<uint64_t>(k + 2048) >> 1) - 1024;
+    int64_t k2     = k - k1;
+    double scale_1 = std::bit_cast<double>(static_cast<uint64_t>(k1 + 1023) << 52);
+    double scale_2 = std::bit_cast<double>(static_cast<uint64_t>(k2 + 1023) << 52);
+    double y       = p * scale_1 * scale_2;
+
+    y = (x > x_max) ? std::numeric_limits<double>::infinity() : y;
+    y = (x < x_min) ? 0.0 : y;
+    return (x != x) ? x : y;
+}
+
+// log(x): x = m 2^e with m in [sqrt(1/2), sqrt(2)), log(m) = 2 atanh(s), s = (m-1)/(m+1)
+MAXENT_INLINE double log_kernel(double x)
+{
+    constexpr double ln2_hi = 6.93147180369123816490e-01;
+    constexpr double ln2_lo = 1.90821492927058770002e-10;
+    constexpr double sqrt2  = 1.41421356237309504880;
+    constexpr double two52  = 0x1p52;
+
+    bool tiny = x < std::numeric_limits<double>::min(); // denormals: scale into range first
+    double xs = tiny ? x * 0x1p54 : x;
+
+    uint64_t bits = std::bit_cast<uint64_t>(xs);
+    double m      = std::bit_cast<double>((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    // biased exponent as a double, without a 64-bit int -> double conversion
+    double e = std::bit_cast<double>(0x4330000000000000ULL | (bits >> 52)) - two52 - 1023.0;
+    bool big = m > sqrt2;
+    m        = big ? 0.5 * m : m;
+    e        = e + (big ? 1.0 : 0.0) - (tiny ? 54.0 : 0.0);
+
+    double s  = (m - 1.0) / (m + 1.0);
+    double s2 = s * s;
+    double p  = 1.0 / 21.0;
+    p         = p * s2 + 1.0 / 19.0;
+    p         = p * s2 + 1.0 / 17.0;
+    p         = p * s2 + 1.0 / 15.0;
+    p         = p * s2 + 1.0 / 13.0;
+    p         = p * s2 + 1.0 / 11.0;
+    p         = p * s2 + 1.0 / 9.0;
+    p         = p * s2 + 1.0 / 7.0;
+    p         = p * s2 + 1.0 / 5.0;
+    p         = p * s2 + 1.0 / 3.0;
+    p         = p * s2 + 1.0;
+    double y  = e * ln2_hi + (e * ln2_lo + 2.0 * s * p);
+
+    y = (x == std::numeric_limits<double>::infinity()) ? x : y;
+    y = (x == 0.0) ? -std::numeric_limits<double>::infinity() : y;
+    return (x < 0.0 || x != x) ? std::numeric_limits<double>::quiet_NaN() : y;
+}
+
+// ---------------------------------------------------------------------------------------
+// float
+// ---------------------------------------------------------------------------------------
+
+MAXENT_INLINE float exp_kernel(float x)
+{
+    constexpr float log2e  = 1.44269504088896341f;
+    constexpr float ln2_hi = 0.693359375f;
+    constexpr float ln2_lo = -2.12194440e-4f;
+    constexpr float shift  = 0x1.8p23f;
+    constexpr float x_max  = 88.7228391f;  // log(FLT_MAX)
+    constexpr float x_min  = -103.972084f; // log of the smallest denormal
+
+    float xc  = (x < x_min) ? x_min : x;
+    xc        = (xc > x_max) ? x_max : xc;
+    float kd  = xc * log2e + shift;
+    int32_t k = static_cast<int32_t>(std::bit_cast<uint32_t>(kd) - std::bit_cast<uint32_t>(shift));
+    kd -= shift;
+    float r = (xc - kd * ln2_hi) - kd * ln2_lo;
+
+    float p = 1.0f / 5040.0f;
+    p       = p * r + 1.0f / 720.0f;
+    p       = p * r + 1.0f / 120.0f;
+    p       = p * r + 1.0f / 24.0f;
+    p       = p * r + 1.0f / 6.0f;
+    p       = p * r + 0.5f;
+    p       = p * r + 1.0f;
+    p       = p * r + 1.0f;
+
+    int32_t k1    = (k + 256) / 2 - 128;
+    int32_t k2    = k - k1;
+    float scale_1 = std::bit_cast<float>(static_cast<uint32_t>(k1 + 127) << 23);
+    float scale_2 = std::bit_cast<float>(static_cast<uint32_t>(k2 + 127) << 23);
+    float y       = p * scale_1 * scale_2;
+
+    y = (x > x_max) ? std::numeric_limits<float>::infinity() : y;
+    y = (x < x_min) ? 0.0f : y;
+    return (x != x) ? x : y;
+}
+
+MAXENT_INLINE float log_kernel(float x)
+{
+    constexpr float ln2_hi = 0.693359375f;
+    constexpr float ln2_lo = -2.12194440e-4f;
+    constexpr float sqrt2  = 1.41421356f;
+
+    bool tiny = x < std::numeric_limits<float>::min();
+    float xs  = tiny ? x * 0x1p24f : x;
+
+    uint32_t bits = std::bit_cast<uint32_t>(xs);
+    float m       = std::bit_cast<float>((bits & 0x007fffffU) | 0x3f800000U);
+    float e       = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    bool big      = m > sqrt2;
+    m             = big ? 0.5f * m : m;
+    e             = e + (big ? 1.0f : 0.0f) - (tiny ? 24.0f : 0.0f);
+
+    float s  = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    float p  = 1.0f / 11.0f;
+    p        = p * s2 + 1.0f / 9.0f;
+    p        = p * s2 + 1.0f / 7.0f;
+    p        = p * s2 + 1.0f / 5.0f;
+    p        = p * s2 + 1.0f / 3.0f;
+    p        = p * s2 + 1.0f;
+    float y  = e * ln2_hi + (e * ln2_lo + 2.0f * s * p);
+
+    y = (x == std::numeric_limits<float>::infinity()) ? x : y;
+    y = (x == 0.0f) ? -std::numeric_limits<float>::infinity() : y;
+    return (x < 0.0f || x != x) ? std::numeric_limits<float>::quiet_NaN() : y;
+}
+
+// ---------------------------------------------------------------------------------------
+// batches, shared by double and float
+// ---------------------------------------------------------------------------------------
+
+template <typename T> MAXENT_INLINE void exp_q_loop(const T *x, T *y, std::size_t n, T q)
+{
+    if (q == T(1))
+    {
+#pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+            y[i] = exp_kernel(x[i]);
+        return;
+    }
+    const T one_minus_q = T(1) - q;
+    const T inv         = T(1) / one_minus_q;
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        // [b]_+^(1/(1-q)) = exp(log(b) / (1-q)); log(b <= 0) is NaN and replaced by 0
+        T b  = T(1) + one_minus_q * x[i];
+        T yi = exp_kernel(log_kernel(b) * inv);
+        y[i] = (b > T(0)) ? yi : T(0);
+    }
+}
+
+template <typename T> MAXENT_INLINE void logistic_loop(const T *x, T *y, std::size_t n)
+{
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+        y[i] = T(1) / (T(1) + exp_kernel(-x[i]));
+}
+
+template <typename T> MAXENT_INLINE void log_q_loop(const T *x, T *y, std::size_t n, T q)
+{
+    if (q == T(1))
+    {
+#pragma omp simd
+        for (std::size_t i = 0; i < n; ++i)
+            y[i] = log_kernel(x[i]);
+        return;
+    }
+    const T one_minus_q = T(1) - q;
+    const T inv         = T(1) / one_minus_q;
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+        y[i] = (exp_kernel(one_minus_q * log_kernel(x[i])) - T(1)) * inv;
+}
+
+} // namespace
+
+namespace utils
+{
+
+MAXENT_TARGET_CLONES void exp_q_batch(const double *x, double *y, std::size_t n, double q)
+{
+    exp_q_loop(x, y, n, q);
+}
+
+MAXENT_TARGET_CLONES void exp_q_batch(const float *x, float *y, std::size_t n, float q)
+{
+    exp_q_loop(x, y, n, q);
+}
+
+MAXENT_TARGET_CLONES void logistic_batch(const double *x, double *y, std::size_t n)
+{
+    logistic_loop(x, y, n);
+}
+
+MAXENT_TARGET_CLONES void logistic_batch(const float *x, float *y, std::size_t n)
+{
+    logistic_loop(x, y, n);
+}
+
+MAXENT_TARGET_CLONES void log_q_batch(const double *x, double *y, std::size_t n, double q)
+{
+    log_q_loop(x, y, n, q);
+}
+
+MAXENT_TARGET_CLONES void log_q_batch(const float *x, float *y, std::size_t n, float q)
+{
+    log_q_loop(x, y, n, q);
+}
+
+} // namespace utils
@@ -50,4 +50,5 @@ void full_ensemble_no_update(RunParameters params)
 
     logger->info("before save model");
     model.saveModel(params.file_final, false);
+    model.clearEnumerationCheckpoints();
 }
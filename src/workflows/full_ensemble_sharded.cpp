@@ -0,0 +1,85 @@
+#include "workflows/full_ensemble_sharded.hpp"
+#include "io/accumulator_file.hpp"
+#include "io/make_file_names.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "utils/get_logger.hpp"
+
+// --------------------------------------------------------
+// Sharded full enumeration, without MPI:
+//
+//   Full_Shard  (one process per shard_index = 0..K-1)
+//       enumerates chunks [k N/K, (k+1) N/K) of the N chunks of
+//       the trained model and writes the unnormalized sums to
+//       result_dir/shards/shard_$(runid)_n$(nspins)_$(k)of$(K).bin
+//
+//   Full_Merge  (once, after all shards finished)
+//       reads the K shard files, checks that they belong to the
+//       same model and cover all 2^n states, and writes the
+//       model JSON like a Full_Ensemble run without updates.
+//
+// Shards and merge must use the same parameters (apart from
+// shard_index): the files carry a fingerprint of the model,
+// q and enum_chunk_log2.
+// --------------------------------------------------------
+void fullEnsembleShardWorkflow(RunParameters params)
+{
+    auto logger = getLogger();
+
+    MaxEntCore core(params.nspins, params.runid);
+    FullEnsembleTrainer model(core, params, params.trained_model_file);
+
+    uint64_t n_chunks    = model.numberOfChunks();
+    uint64_t first_chunk = n_chunks * params.shard_index / params.shard_count;
+    uint64_t last_chunk  = n_chunks * (params.shard_index + 1) / params.shard_count;
+    if (first_chunk == last_chunk)
+        logger->warn("[fullEnsembleShard] shard {} of {} has no chunks ({} in total)",
+                     params.shard_index, params.shard_count, n_chunks);
+
+    logger->info("[fullEnsembleShard] shard {} of {}: chunks [{}, {}) of {}", params.shard_index,
+                 params.shard_count, first_chunk, last_chunk, n_chunks);
+    EnsembleAccumulator acc = model.enumerateChunks(first_chunk, last_chunk, 1.0, true);
+
+    auto shard_file = io::make_shard_filename(params, params.shard_index);
+    io::writeAccumulator(acc, model.enumerationFingerprint(1.0, true), shard_file);
+    model.clearEnumerationCheckpoints();
+    logger->info("[fullEnsembleShard] saved {} states to {}", acc.n_states, shard_file);
+}
+
+void fullEnsembleMergeWorkflow(RunParameters params)
+{
+    auto logger = getLogger();
+
+    MaxEntCore core(params.nspins, params.runid);
+    FullEnsembleTrainer model(core, params, params.trained_model_file);
+
+    uint64_t fingerprint = model.enumerationFingerprint(1.0, true);
+    EnsembleAccumulator acc;
+    for (int k = 0; k < params.shard_count; ++k)
+    {
+        auto shard_file = io::make_shard_filename(params, k);
+        EnsembleAccumulator part;
+        if (!io::readAccumulator(shard_file, fingerprint, part))
+        {
+            logger->error("[fullEnsembleMerge] missing, unreadable or foreign shard file {}",
+                          shard_file);
+            throw std::runtime_error("Can't merge shard " + std::to_string(k));
+        }
+        if (k == 0)
+            acc = part;
+        else
+            acc.merge(part);
+    }
+
+    uint64_t total = uint64_t(1) << core.nspins;
+    if (acc.n_states != total)
+    {
+        logger->error("[fullEnsembleMerge] shards cover {} states, expected {}", acc.n_states,
+                      total);
+        throw std::runtime_error("Incomplete set of shards");
+    }
+
+    model.storeAverages(acc, true);
+    model.saveModel(params.file_final, false);
+    logger->info("[fullEnsembleMerge] merged {} shards into {}", params.shard_count,
+                 params.file_final);
+}
@@ -19,4 +19,5 @@ void fullEnsembleTrainingWorkflow(RunParameters params)
     model.train();
     
     model.saveModel(params.file_final, true);
+    model.clearEnumerationCheckpoints();
 }
@@ -3,6 +3,7 @@
 #include "trainers/full_ensemble_trainer.hpp"
 #include "trainers/heat_bath_trainer.hpp"
 #include "utils/correlation_histogram.hpp"
+#include "utils/energy_levels.hpp"
 #include "utils/get_logger.hpp"
 
 #include <armadillo>
@@ -30,7 +31,7 @@ void save_histogram_to_csv(const std::vector<double> &bin_centers,
     }
 }
 
-void save_replicas_to_csv(const arma::Mat<int> &replicas, const std::string &filename)
+void save_replicas_to_csv(const utils::ReplicaView &replicas, const std::string &filename)
 {
     std::ofstream replicas_out(filename);
 
@@ -39,12 +40,12 @@ void save_replicas_to_csv(const arma::Mat<int> &replicas, const std::string &fil
         throw std::runtime_error("Could not open file for writing: " + filename);
     }
 
-    for (size_t i = 0; i < replicas.n_rows; ++i)
+    for (size_t i = 0; i < replicas.n_rows(); ++i)
     {
-        for (size_t j = 0; j < replicas.n_cols; ++j)
+        for (int j = 0; j < replicas.n_spins(); ++j)
         {
             replicas_out << replicas(i, j);
-            if (j + 1 < replicas.n_cols)
+            if (j + 1 < replicas.n_spins())
                 replicas_out << ",";
         }
         replicas_out << "\n";
@@ -86,17 +87,39 @@ void runTemperatureDependence(RunParameters &params)
 
     if (nspins < 21)
     { // loop to compute T, beta, <E>, <CV> <mag>, full ensemble is more accurate
+        // single pass: the 2^n states are enumerated once, every beta reads the energy levels
+        utils::EnergyLevels levels;
+        if (params.tdep_single_pass)
+        {
+            levels = model_full.computeEnergyLevels();
+            logger->info("[runTemperatureDependence] {} distinct energies", levels.energy.size());
+        }
+
         std::size_t i = 0;
         for (double beta : params.beta_range)
         {
             double T = 1.0 / beta;
 
-            model_full.computeModelAverages(beta, true);
-            double energy = model_full.get_avg_energy();
-            double specific_heat =
-                (model_full.get_avg_energy_sq() - std::pow(energy, 2.0)) / (T * T);
-            double magnetization = model_full.get_avg_magnetization();
-            double f_supp        = model_full.get_f_supp();
+            utils::ThermalAverages avg;
+            if (params.tdep_single_pass)
+            {
+                avg = utils::thermalAverages(levels, beta, params.q_val);
+            }
+            else
+            {
+                model_full.computeModelAverages(beta, true);
+                avg.energy            = model_full.get_avg_energy();
+                avg.energy_sq         = model_full.get_avg_energy_sq();
+                avg.magnetization     = model_full.get_avg_magnetization();
+                avg.f_supp            = model_full.get_f_supp();
+                avg.max_weight        = model_full.get_max_weight();
+                avg.max_bracket       = model_full.get_max_bracket();
+                avg.max_weight_energy = model_full.get_max_weight_energy();
+            }
+            double energy        = avg.energy;
+            double specific_heat = (avg.energy_sq - std::pow(energy, 2.0)) / (T * T);
+            double magnetization = avg.magnetization;
+            double f_supp        = avg.f_supp;
 
             logger->info("[runTemperatureDependence]  T={:.2f} beta={:.2f} E={:.2f} CV={:.2f} "
                          "M={:.2f} fsupp={:.2e}",
@@ -106,16 +129,16 @@ void runTemperatureDependence(RunParameters &params)
             CV(i)              = specific_heat;
             M(i)               = magnetization;
             FSUPP(i)           = f_supp;
-            MaxWeight(i)       = model_full.get_max_weight();
-            MaxBracket(i)      = model_full.get_max_bracket();
-            MaxWeightEnergy(i) = model_full.get_max_weight_energy();
+            MaxWeight(i)       = avg.max_weight;
+            MaxBracket(i)      = avg.max_bracket;
+            MaxWeightEnergy(i) = avg.max_weight_energy;
 
             if (params.compute_replica_cor)
             {
                 // need model_mc to compute replica correlations
                 model_mc.computeModelAverages(beta, true);
-                auto replicas                   = model_mc.get_replicas();
-                auto [bin_centers, hist_values] = correlation_histogram<int>(replicas, 2.0, true);
+                const auto replicas             = model_mc.get_replicas(); // a view, no copy
+                auto [bin_centers, hist_values] = correlation_histogram(replicas);
                 auto max_it    = std::max_element(hist_values.begin(), hist_values.end());
                 size_t max_idx = std::distance(hist_values.begin(), max_it);
                 double q_max   = bin_centers[max_idx];
@@ -150,8 +173,8 @@ void runTemperatureDependence(RunParameters &params)
                 beta * beta * (model_mc.get_avg_energy_sq() - std::pow(energy, 2.0));
             double magnetization = model_mc.get_avg_magnetization();
 
-            auto replicas                   = model_mc.get_replicas();
-            auto [bin_centers, hist_values] = correlation_histogram<int>(replicas, 2.0, true);
+            const auto replicas             = model_mc.get_replicas();
+            auto [bin_centers, hist_values] = correlation_histogram(replicas);
             auto max_it    = std::max_element(hist_values.begin(), hist_values.end());
             size_t max_idx = std::distance(hist_values.begin(), max_it);
             double q_max   = bin_centers[max_idx];
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+/**
+ * @brief A path in the temporary directory that no other test uses, ending in suffix.
+ *
+ * The name carries the test, the process and a counter, so tests run in parallel (ctest -j,
+ * or two test runs on one machine) never share a file or a directory.
+ */
+inline std::filesystem::path uniqueTempPath(const std::string &suffix)
+{
+    static std::atomic<int> counter{0};
+    std::string test = "maxent";
+    if (const auto *info = ::testing::UnitTest::GetInstance()->current_test_info())
+        test = std::string(info->test_suite_name()) + "." + info->name();
+    return std::filesystem::temp_directory_path() /
+           (test + "-" + std::to_string(getpid()) + "-" + std::to_string(counter++) + suffix);
+}
+
+/**
+ * @brief A few +-1 samples in a temporary CSV file, so that a trainer can be constructed.
+ *
+ * The trainers read the file in their constructor only, so a temporary is enough:
+ *
+ *     HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+ *
+ * The file has a uniqueTempPath() and is removed with the object.
+ */
+class SamplesFile
+{
+  public:
+    explicit SamplesFile(int nspins)
+    {
+        file = uniqueTempPath("-n" + std::to_string(nspins) + ".csv");
+
+        std::ofstream out(file);
+        std::mt19937 rng(7);
+        for (int r = 0; r < 20; ++r)
+        {
+            for (int i = 0; i < nspins; ++i)
+                out << ((rng() & 1) ? 1 : -1) << (i + 1 < nspins ? "," : "\n");
+        }
+    }
+
+    ~SamplesFile()
+    {
+        std::error_code ignored;
+        std::filesystem::remove(file, ignored);
+    }
+
+    SamplesFile(const SamplesFile &)            = delete;
+    SamplesFile &operator=(const SamplesFile &) = delete;
+
+    std::string path() const
+    {
+        return file.string();
+    }
+
+  private:
+    std::filesystem::path file;
+};
+
+/**
+ * @brief An empty temporary directory with a uniqueTempPath(), removed with its contents
+ * when the object goes.
+ */
+class ScratchDirectory
+{
+  public:
+    explicit ScratchDirectory(const std::string &name) : dir(uniqueTempPath("-" + name))
+    {
+        std::filesystem::create_directories(dir);
+    }
+
+    ~ScratchDirectory()
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all(dir, ignored);
+    }
+
+    ScratchDirectory(const ScratchDirectory &)            = delete;
+    ScratchDirectory &operator=(const ScratchDirectory &) = delete;
+
+    const std::filesystem::path &path() const
+    {
+        return dir;
+    }
+
+  private:
+    std::filesystem::path dir;
+};
@@ -0,0 +1,169 @@
+#include "samples_file.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "trainers/heat_bath_trainer.hpp"
+#include "trainers/wang_landau_trainer.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+// The inner loops of the enumeration and of the Monte Carlo samplers must not allocate: the
+// number of heap allocations of a call may depend on the model size, but not on how many
+// states, sweeps or proposals it runs. Every allocation of the process, including
+// armadillo's (which bypass operator new), is counted by replacing the glibc allocation
+// functions.
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+std::atomic<bool> counting{false};
+std::atomic<size_t> n_allocations{0};
+
+inline void count_allocation()
+{
+    if (counting.load(std::memory_order_relaxed))
+        n_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace
+
+extern "C"
+{
+    void *malloc(size_t size) noexcept
+    {
+        count_allocation();
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size) noexcept
+    {
+        count_allocation();
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size) noexcept
+    {
+        count_allocation();
+        return __libc_realloc(ptr, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size) noexcept
+    {
+        count_allocation();
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr ? 0 : ENOMEM;
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        count_allocation();
+        return __libc_memalign(alignment, size);
+    }
+}
+
+namespace
+{
+// heap allocations made by f
+size_t allocations(const std::function<void()> &f)
+{
+    n_allocations = 0;
+    counting      = true;
+    f();
+    counting = false;
+    return n_allocations;
+}
+
+void random_model(MaxEntCore &core)
+{
+    std::mt19937 rng(11);
+    std::normal_distribution<double> dist(0.0, 0.3);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+}
+} // namespace
+
+TEST(AllocationTest, EnumerationDoesNotAllocatePerState)
+{
+    // one chunk of 2^9 states, one of 2^13 states, and 16 chunks of 2^9 states
+    auto run = [](int nspins, int chunk_log2)
+    {
+        RunParameters params;
+        params.run_type        = "Full_Ensemble";
+        params.nspins          = nspins;
+        params.enum_chunk_log2 = chunk_log2;
+        MaxEntCore core(nspins, "test");
+        random_model(core);
+        FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+        model.computeModelAverages(1.0, true); // warm-up: thread pool
+        return allocations([&] { model.computeModelAverages(1.0, true); });
+    };
+    size_t small  = run(10, 22);
+    size_t large  = run(14, 22);
+    size_t chunks = run(14, 9);
+    EXPECT_GT(small, 0u); // the accumulators are counted
+    EXPECT_EQ(small, large);
+    EXPECT_EQ(large, chunks);
+}
+
+TEST(AllocationTest, HeatBathSweepsDoNotAllocate)
+{
+    auto run = [](size_t step_equilibration, size_t step_correlation, int lanes = 1)
+    {
+        int nspins = 12;
+        RunParameters params;
+        params.run_type           = "Heat_Bath";
+        params.nspins             = nspins;
+        params.step_equilibration = step_equilibration;
+        params.step_correlation   = step_correlation;
+        params.num_samples        = 200;
+        params.number_repetitions = 2;
+        params.hb_lanes           = lanes;
+        MaxEntCore core(nspins, "test");
+        random_model(core);
+        HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+        model.computeModelAverages(1.0, false);
+        return allocations([&] { model.computeModelAverages(1.0, false); });
+    };
+    EXPECT_EQ(run(10, 1), run(1000, 20));
+    EXPECT_EQ(run(10, 1, 8), run(1000, 20, 8));
+}
+
+TEST(AllocationTest, WangLandauProposalsDoNotAllocate)
+{
+    auto run = [](size_t step_equilibration, size_t step_correlation)
+    {
+        int nspins = 8;
+        RunParameters params;
+        params.run_type           = "MC";
+        params.nspins             = nspins;
+        params.step_equilibration = step_equilibration;
+        params.step_correlation   = step_correlation;
+        params.num_samples        = 200;
+        params.log_f_final        = 1e-2;
+        MaxEntCore core(nspins, "test");
+        random_model(core);
+        WangLandauTrainer model(core, params, SamplesFile(nspins).path());
+        model.computeDensityOfStates();
+        model.computeModelAverages(1.0, true);
+        return allocations(
+            [&]
+            {
+                model.computeDensityOfStates();
+                model.computeModelAverages(1.0, true);
+            });
+    };
+    EXPECT_EQ(run(500, 1), run(5000, 10));
+}
+#endif
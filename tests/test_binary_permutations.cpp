@@ -26,7 +26,7 @@ TEST(BinaryPermutationsSequenceTest, FullSequence) {
 
     for (const auto& state : sequence) {
         ASSERT_LT(index, expected_states.size()) << "Generated too many states.";
-        EXPECT_EQ(state.n_elem, nspins) << "State does not have the correct number of spins.";
+        EXPECT_EQ(state.size(), nspins) << "State does not have the correct number of spins.";
         std::vector<int> state_vector(state.begin(), state.end());
         EXPECT_EQ(state_vector, expected_states[index]) << "State at index " << index << " does not match expected.";
         ++index;
@@ -81,7 +81,7 @@ TEST(BinaryPermutationsSequenceTest, PartialSequence) {
     index=start;
     for (const auto& state : sequence) {
         ASSERT_LT(index, expected_states.size()) << "Generated too many states.";
-        EXPECT_EQ(state.n_elem, nspins) << "State does not have the correct number of spins.";
+        EXPECT_EQ(state.size(), nspins) << "State does not have the correct number of spins.";
         std::vector<int> state_vector(state.begin(), state.end());
         EXPECT_EQ(state_vector, expected_states[index]) << "State at index " << index << " does not match expected.";
         ++index;
@@ -89,3 +89,22 @@ TEST(BinaryPermutationsSequenceTest, PartialSequence) {
 
     ASSERT_EQ(index, expected_states.size()) << "Number of generated states does not match expected.";
 }
+
+TEST(BinaryPermutationsSequenceTest, IndicesBeyond32Bits) {
+    // n = 36: the first states of the second half have s_0 = -1 and index >= 2^35
+    int nspins     = 36;
+    uint64_t start = (uint64_t(1) << 35) + 5; // 100...0101
+    BinaryPermutationsSequence sequence(nspins, start, start + 2);
+
+    std::vector<std::vector<int>> states;
+    for (const auto &state : sequence)
+        states.emplace_back(state.begin(), state.end());
+
+    ASSERT_EQ(states.size(), 2u);
+    for (int i = 0; i < nspins; ++i) {
+        int expected_first  = (i == 0 || i == 33 || i == 35) ? -1 : +1; // ...0101
+        int expected_second = (i == 0 || i == 33 || i == 34) ? -1 : +1; // ...0110
+        EXPECT_EQ(states[0][i], expected_first) << "spin " << i;
+        EXPECT_EQ(states[1][i], expected_second) << "spin " << i;
+    }
+}
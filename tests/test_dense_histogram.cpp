@@ -0,0 +1,73 @@
+#include "utils/dense_histogram.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+// the present bins of a histogram, in iteration order
+std::vector<std::pair<int, double>> bins_of(const utils::DenseHistogram<double> &H)
+{
+    std::vector<std::pair<int, double>> out;
+    for (const auto &[bin, value] : H)
+        out.emplace_back(bin, value);
+    return out;
+}
+} // namespace
+
+TEST(DenseHistogramTest, MatchesMapHistogram)
+{
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> bin_dist(-40, 40);
+    std::uniform_real_distribution<double> weight_dist(0.0, 1.0);
+
+    utils::DenseHistogram<double> H(-20, 20); // narrower than the bins used: must grow
+    std::map<int, double> ref;
+    for (int r = 0; r < 2000; ++r)
+    {
+        int bin = bin_dist(rng);
+        double w = (r % 7 == 0) ? 0.0 : weight_dist(rng); // zero weights still mark a bin
+        H[bin] += w;
+        ref[bin] += w;
+    }
+
+    EXPECT_EQ(H.size(), ref.size());
+    auto bins = bins_of(H);
+    ASSERT_EQ(bins.size(), ref.size());
+    size_t b = 0;
+    for (const auto &[bin, value] : ref)
+    {
+        EXPECT_EQ(bins[b].first, bin);
+        EXPECT_DOUBLE_EQ(bins[b].second, value);
+        ++b;
+    }
+    EXPECT_FALSE(H.contains(100));
+    EXPECT_EQ(H.at(100), 0.0);
+}
+
+TEST(DenseHistogramTest, MergeAddsBinsAndKeepsZeroBins)
+{
+    utils::DenseHistogram<double> a(-5, 5), b(-5, 5), c(3, 12);
+    a[-5] += 1.0;
+    a[0] += 2.0;
+    b[0] += 3.0;
+    b[4] += 0.0;
+    c[12] += 4.0;
+
+    a.merge(b); // same range
+    a.merge(c); // different range
+    a.merge(utils::DenseHistogram<double>());
+
+    auto bins = bins_of(a);
+    std::vector<std::pair<int, double>> expected = {{-5, 1.0}, {0, 5.0}, {4, 0.0}, {12, 4.0}};
+    EXPECT_EQ(bins, expected);
+
+    a.scale(0.5);
+    EXPECT_DOUBLE_EQ(a.at(0), 2.5);
+
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(a.min_bin(), -5);
+    EXPECT_EQ(a.max_bin(), 12);
+}
@@ -0,0 +1,515 @@
+#include "io/accumulator_file.hpp"
+#include "samples_file.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+// Every full_engine must reproduce the single-threaded reference computeModelAverages1.
+
+namespace
+{
+// the settings of a comparison besides the engine, q and beta
+struct CompareOptions
+{
+    int nspins            = 7;
+    double tol            = 1e-10;
+    int chunk_log2        = 22;
+    std::string precision = "double";
+    std::string cache     = "none";
+    bool with_K           = true;
+    bool triplets         = true;
+};
+
+void compare_with_reference(const std::string &engine,
+                            double q_val,
+                            double beta,
+                            const CompareOptions &options = {})
+{
+    const int nspins = options.nspins;
+    const double tol = options.tol;
+
+    RunParameters params;
+    params.run_type        = "Full_Ensemble";
+    params.nspins          = nspins;
+    params.q_val           = q_val;
+    params.full_engine     = engine;
+    params.enum_chunk_log2 = options.chunk_log2;
+    params.enum_precision  = options.precision;
+    params.energy_cache    = options.cache;
+    MaxEntCore core(nspins, "test");
+    FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+    std::mt19937 rng(11);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+    for (auto &x : core.K)
+        x = options.with_K ? 0.2 * dist(rng) : 0.0;
+
+    model.computeModelAverages1(beta, options.triplets);
+    arma::vec m1 = model.get_m1_model(), m2 = model.get_m2_model(), m3 = model.get_m3_model();
+    arma::vec pK   = model.get_pK_model();
+    double energy  = model.get_avg_energy();
+    double energy2 = model.get_avg_energy_sq();
+    double mag     = model.get_avg_magnetization();
+
+    model.computeModelAverages(beta, options.triplets);
+    for (size_t i = 0; i < m1.n_elem; ++i)
+        EXPECT_NEAR(model.get_m1_model()(i), m1(i), tol) << engine << " m1 " << i;
+    for (size_t i = 0; i < m2.n_elem; ++i)
+        EXPECT_NEAR(model.get_m2_model()(i), m2(i), tol) << engine << " m2 " << i;
+    for (size_t i = 0; i < m3.n_elem; ++i)
+        EXPECT_NEAR(model.get_m3_model()(i), m3(i), tol) << engine << " m3 " << i;
+    for (size_t i = 0; i < pK.n_elem; ++i)
+        EXPECT_NEAR(model.get_pK_model()(i), pK(i), tol) << engine << " pK " << i;
+    EXPECT_NEAR(model.get_avg_energy(), energy, tol) << engine;
+    EXPECT_NEAR(model.get_avg_energy_sq(), energy2, tol) << engine;
+    EXPECT_NEAR(model.get_avg_magnetization(), mag, tol) << engine;
+}
+} // namespace
+
+TEST(FullEnsembleEnginesTest, EnumerationMatchesReference)
+{
+    compare_with_reference("enumeration", 1.0, 1.0);
+    compare_with_reference("enumeration", 0.7, 1.5);
+    // 64 chunks of 8 states
+    compare_with_reference("enumeration", 1.0, 1.0, {.nspins = 10, .chunk_log2 = 3});
+}
+
+TEST(FullEnsembleEnginesTest, SinglePrecisionMatchesReference)
+{
+    const double tol = FullEnsembleTrainer::single_precision_tolerance;
+    compare_with_reference("enumeration", 1.0, 1.0, {.tol = tol, .precision = "float"});
+    compare_with_reference("enumeration", 0.7, 1.5, {.tol = tol, .precision = "float"});
+    compare_with_reference("enumeration", 1.3, 2.0, {.tol = tol, .precision = "float"});
+    compare_with_reference("enumeration", 1.0, 1.0, // partial blocks
+                           {.nspins = 11, .tol = tol, .chunk_log2 = 3, .precision = "float"});
+    compare_with_reference("enumeration", 1.0, 1.0,
+                           {.nspins = 9, .tol = tol, .precision = "float", .cache = "double"});
+    compare_with_reference("enumeration", 1.0, 1.0, {.precision = "validate"});
+}
+
+TEST(FullEnsembleEnginesTest, EveryKernelSpecializationMatchesReference)
+{
+    for (std::string precision : {"double", "float"})
+    {
+        double tol = (precision == "float") ? FullEnsembleTrainer::single_precision_tolerance
+                                            : 1e-10;
+        for (double q : {1.0, 0.7})
+            for (bool with_K : {false, true})
+                for (bool triplets : {false, true})
+                    compare_with_reference("enumeration", q, 1.5,
+                                           {.tol       = tol,
+                                            .precision = precision,
+                                            .with_K    = with_K,
+                                            .triplets  = triplets});
+    }
+}
+
+TEST(FullEnsembleEnginesTest, WalshHadamardMatchesReference)
+{
+    compare_with_reference("wht", 1.0, 1.0);
+    compare_with_reference("wht", 0.7, 1.5);
+}
+
+TEST(FullEnsembleEnginesTest, GrayCodeMatchesReference)
+{
+    compare_with_reference("gray", 1.0, 1.0);
+    compare_with_reference("gray", 0.7, 1.5);
+}
+
+TEST(FullEnsembleEnginesTest, BlockedMatchesReference)
+{
+    compare_with_reference("blocked", 1.0, 1.0);
+    compare_with_reference("blocked", 0.7, 1.5);
+    compare_with_reference("blocked", 1.0, 0.5, {.nspins = 15}); // 6 outer + 9 inner spins
+}
+
+TEST(FullEnsembleEnginesTest, EnginesRejectTooManySpins)
+{
+    // 2^nspins states: the engines refuse sizes they cannot enumerate before shifting by it
+    const int nspins = 64;
+    for (const std::string engine : {"gray", "blocked"})
+    {
+        RunParameters params;
+        params.run_type    = "Full_Ensemble";
+        params.nspins      = nspins;
+        params.full_engine = engine;
+        MaxEntCore core(nspins, "test");
+        FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+        EXPECT_THROW(model.computeModelAverages(1.0, false), std::runtime_error) << engine;
+    }
+}
+
+TEST(FullEnsembleEnginesTest, PrunedMatchesReference)
+{
+    compare_with_reference("pruned", 1.0, 1.0); // no cutoff: falls back to the enumeration
+    compare_with_reference("pruned", 0.7, 1.5);
+    compare_with_reference("pruned", 0.5, 3.0, {.nspins = 12, .triplets = false});
+    compare_with_reference("pruned", 0.3, 8.0, {.nspins = 11}); // most of the hypercube pruned
+}
+
+TEST(FullEnsembleEnginesTest, PrunedCountsSupportExactly)
+{
+    int nspins = 12;
+    RunParameters params;
+    params.run_type    = "Full_Ensemble";
+    params.nspins      = nspins;
+    params.q_val       = 0.4;
+    MaxEntCore core(nspins, "test");
+    FullEnsembleTrainer enumeration(core, params, SamplesFile(nspins).path());
+    params.full_engine = "pruned";
+    FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+    std::mt19937 rng(23);
+    std::normal_distribution<double> dist(0.0, 0.6);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+
+    for (double beta : {0.5, 2.0, 6.0})
+    {
+        enumeration.computeModelAverages(beta, true);
+        double f_supp = enumeration.get_f_supp();
+        model.computeModelAverages(beta, true);
+        EXPECT_DOUBLE_EQ(model.get_f_supp(), f_supp) << "beta " << beta;
+        EXPECT_LT(f_supp, 1.0) << "beta " << beta;
+
+        // pruned states are never binned: no partial density of states is stored
+        EXPECT_TRUE(model.get_GE().empty()) << "beta " << beta;
+        EXPECT_TRUE(model.get_PE().empty()) << "beta " << beta;
+    }
+}
+
+TEST(FullEnsembleEnginesTest, SectorsMatchReference)
+{
+    compare_with_reference("sectors", 1.0, 1.0);
+    compare_with_reference("sectors", 0.7, 1.5);
+    // sectors in pieces of 8
+    compare_with_reference("sectors", 1.0, 1.0, {.nspins = 10, .chunk_log2 = 3});
+    compare_with_reference("sectors", 1.0, 1.0, {.nspins = 9, .cache = "double"});
+}
+
+TEST(FullEnsembleEnginesTest, SectorStatisticsDecomposeAverages)
+{
+    int nspins = 10;
+    RunParameters params;
+    params.run_type    = "Full_Ensemble";
+    params.nspins      = nspins;
+    params.full_engine = "sectors";
+    MaxEntCore core(nspins, "test");
+    FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+    std::mt19937 rng(29);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+    for (auto &x : core.K)
+        x = 0.2 * dist(rng);
+
+    model.computeModelAverages(1.0, false);
+    const arma::vec &Z_k = model.get_sector_Z();
+    ASSERT_EQ(Z_k.n_elem, size_t(nspins + 1));
+
+    // Z_k / Z = p(k), and the sector averages weighted by p(k) are the averages
+    arma::vec pK = Z_k / arma::accu(Z_k);
+    EXPECT_LT(arma::max(arma::abs(pK - model.get_pK_model())), 1e-12);
+    EXPECT_LT(arma::max(arma::abs(model.get_sector_m1() * pK - model.get_m1_model())), 1e-12);
+    EXPECT_LT(arma::max(arma::abs(model.get_sector_m2() * pK - model.get_m2_model())), 1e-12);
+
+    // the all-up sector holds the single state s = +1
+    for (int i = 0; i < nspins; ++i)
+        EXPECT_DOUBLE_EQ(model.get_sector_m1()(i, nspins), 1.0);
+    for (int k = 0; k <= nspins; ++k)
+        EXPECT_NEAR(arma::accu(model.get_sector_m1().col(k)), 2.0 * k - nspins, 1e-10);
+}
+
+TEST(FullEnsembleEnginesTest, EnergyCacheFollowsParameterUpdates)
+{
+    for (std::string cache : {"double", "float"})
+    {
+        for (std::string engine : {"enumeration", "wht"})
+        {
+            int nspins = 8;
+            double tol = (cache == "float") ? 1e-5 : 1e-10;
+
+            RunParameters params;
+            params.run_type     = "Full_Ensemble";
+            params.nspins       = nspins;
+            params.full_engine  = engine;
+            params.energy_cache = cache;
+            MaxEntCore core(nspins, "test");
+            FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+            std::mt19937 rng(5);
+            std::normal_distribution<double> dist(0.0, 0.4);
+            auto check = [&](const std::string &when)
+            {
+                std::string step = engine + "/" + cache + " " + when;
+                model.computeModelAverages1(1.0, false);
+                arma::vec m1 = model.get_m1_model(), m2 = model.get_m2_model();
+                double energy = model.get_avg_energy();
+                model.computeModelAverages(1.0, false);
+                EXPECT_LT(arma::max(arma::abs(model.get_m1_model() - m1)), tol) << step;
+                EXPECT_LT(arma::max(arma::abs(model.get_m2_model() - m2)), tol) << step;
+                EXPECT_NEAR(model.get_avg_energy(), energy, tol) << step;
+            };
+
+            // first call builds the table
+            for (auto &x : core.h)
+                x = dist(rng);
+            for (auto &x : core.J)
+                x = dist(rng);
+            check("build");
+
+            // coordinate-descent steps: one h_i and one J_ij, patched in place
+            for (int t = 0; t < 5; ++t)
+            {
+                core.h(t) += 0.1 * dist(rng);
+                core.J(3 * t) += 0.1 * dist(rng);
+                core.K(t) += 0.1 * dist(rng);
+                check("patch " + std::to_string(t));
+            }
+
+            // every parameter changed: full rebuild
+            core.J += 0.05;
+            check("rebuild");
+        }
+    }
+}
+
+TEST(FullEnsembleEnginesTest, EnergyLevelsReproduceEveryTemperature)
+{
+    int nspins = 8;
+    for (double q : {1.0, 0.7})
+    {
+        RunParameters params;
+        params.run_type = "Full_Ensemble";
+        params.nspins   = nspins;
+        params.q_val    = q;
+        MaxEntCore core(nspins, "test");
+        FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+        std::mt19937 rng(13);
+        std::normal_distribution<double> dist(0.0, 0.4);
+        for (auto &x : core.h)
+            x = dist(rng);
+        for (auto &x : core.J)
+            x = dist(rng);
+        for (auto &x : core.K)
+            x = 0.2 * dist(rng);
+
+        // one enumeration for all temperatures
+        auto levels = model.computeEnergyLevels();
+        EXPECT_DOUBLE_EQ(arma::accu(arma::vec(levels.degeneracy)), std::pow(2.0, nspins));
+
+        for (double beta : {0.3, 1.0, 2.5})
+        {
+            model.computeModelAverages(beta, false);
+            auto avg       = utils::thermalAverages(levels, beta, q);
+            std::string at = "q=" + std::to_string(q) + " beta=" + std::to_string(beta);
+            EXPECT_NEAR(avg.energy, model.get_avg_energy(), 1e-10) << at;
+            EXPECT_NEAR(avg.energy_sq, model.get_avg_energy_sq(), 1e-10) << at;
+            EXPECT_NEAR(avg.magnetization, model.get_avg_magnetization(), 1e-10) << at;
+            EXPECT_NEAR(avg.f_supp, model.get_f_supp(), 1e-12) << at;
+            EXPECT_NEAR(avg.max_weight, model.get_max_weight(), 1e-10) << at;
+            EXPECT_NEAR(avg.max_bracket, model.get_max_bracket(), 1e-10) << at;
+            EXPECT_NEAR(avg.max_weight_energy, model.get_max_weight_energy(), 1e-10) << at;
+        }
+    }
+}
+
+TEST(FullEnsembleEnginesTest, ChunkCheckpointsAreReused)
+{
+    int nspins = 9;
+    const ScratchDirectory scratch("chunks");
+
+    RunParameters params;
+    params.run_type        = "Full_Ensemble";
+    params.nspins          = nspins;
+    params.enum_chunk_log2 = 4; // 16 chunks
+    params.scratch_dir     = scratch.path().string();
+    MaxEntCore core(nspins, "test");
+    FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+    std::mt19937 rng(17);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+
+    model.computeModelAverages1(1.0, true);
+    arma::vec m1 = model.get_m1_model(), m3 = model.get_m3_model();
+
+    // first evaluation writes every chunk
+    model.computeModelAverages(1.0, true);
+    std::filesystem::path chunk_dir = model.chunkDirectory(1.0, true);
+    size_t n_files = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(chunk_dir))
+        n_files += entry.path().extension() == ".bin";
+    EXPECT_EQ(n_files, 16u);
+
+    // a "crashed" evaluation: half of the chunks are lost, one is corrupted
+    for (int c = 0; c < 8; ++c)
+        std::filesystem::remove(chunk_dir / ("chunk_" + std::to_string(c) + ".bin"));
+    std::ofstream(chunk_dir / "chunk_9.bin") << "garbage";
+
+    model.computeModelAverages(1.0, true);
+    EXPECT_LT(arma::max(arma::abs(model.get_m1_model() - m1)), 1e-12);
+    EXPECT_LT(arma::max(arma::abs(model.get_m3_model() - m3)), 1e-12);
+
+    // another temperature never reads these chunks
+    model.computeModelAverages(0.5, true);
+    model.computeModelAverages1(0.5, true);
+    arma::vec m1_half = model.get_m1_model();
+    model.computeModelAverages(0.5, true);
+    EXPECT_LT(arma::max(arma::abs(model.get_m1_model() - m1_half)), 1e-12);
+
+    model.clearEnumerationCheckpoints();
+    EXPECT_FALSE(std::filesystem::exists(chunk_dir));
+
+    // after a model checkpoint only the evaluation a resume repeats (the first) and the
+    // latest one stay on disk
+    for (double beta : {1.0, 0.5, 0.3})
+        model.computeModelAverages(beta, true);
+    EXPECT_TRUE(std::filesystem::exists(model.chunkDirectory(1.0, true)));
+    EXPECT_FALSE(std::filesystem::exists(model.chunkDirectory(0.5, true)));
+    EXPECT_TRUE(std::filesystem::exists(model.chunkDirectory(0.3, true)));
+    model.clearEnumerationCheckpoints();
+    EXPECT_FALSE(std::filesystem::exists(model.chunkDirectory(1.0, true)));
+    EXPECT_FALSE(std::filesystem::exists(model.chunkDirectory(0.3, true)));
+
+    // the precision of the energy cache is part of the fingerprint (same core, same model)
+    params.energy_cache = "float";
+    FullEnsembleTrainer cached(core, params, SamplesFile(nspins).path());
+    EXPECT_NE(cached.enumerationFingerprint(1.0, true), model.enumerationFingerprint(1.0, true));
+}
+
+TEST(FullEnsembleEnginesTest, ShardFilesMergeToFullEnumeration)
+{
+    int nspins      = 9;
+    int shard_count = 3;
+    const ScratchDirectory shards("shards");
+    const auto &dir = shards.path();
+
+    RunParameters params;
+    params.run_type        = "Full_Ensemble";
+    params.nspins          = nspins;
+    params.enum_chunk_log2 = 4; // 16 chunks over 3 shards
+    MaxEntCore core(nspins, "test");
+    FullEnsembleTrainer model(core, params, SamplesFile(nspins).path());
+
+    std::mt19937 rng(19);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+    for (auto &x : core.K)
+        x = 0.2 * dist(rng);
+
+    model.computeModelAverages(1.0, true);
+    arma::vec m1 = model.get_m1_model(), m2 = model.get_m2_model(), m3 = model.get_m3_model();
+    double energy = model.get_avg_energy();
+
+    // each "process" writes its slice of chunks
+    uint64_t fingerprint = model.enumerationFingerprint(1.0, true);
+    uint64_t n_chunks    = model.numberOfChunks();
+    for (int k = 0; k < shard_count; ++k)
+    {
+        auto acc = model.enumerateChunks(n_chunks * k / shard_count,
+                                         n_chunks * (k + 1) / shard_count, 1.0, true);
+        io::writeAccumulator(acc, fingerprint, (dir / std::to_string(k)).string());
+    }
+
+    // merge step
+    EnsembleAccumulator total;
+    for (int k = 0; k < shard_count; ++k)
+    {
+        EnsembleAccumulator part;
+        ASSERT_TRUE(io::readAccumulator((dir / std::to_string(k)).string(), fingerprint, part));
+        if (k == 0)
+            total = part;
+        else
+            total.merge(part);
+    }
+    EXPECT_EQ(total.n_states, uint64_t(1) << nspins);
+    EXPECT_FALSE(io::readAccumulator((dir / "0").string(), fingerprint + 1, total));
+
+    model.storeAverages(total, true);
+    EXPECT_LT(arma::max(arma::abs(model.get_m1_model() - m1)), 1e-12);
+    EXPECT_LT(arma::max(arma::abs(model.get_m2_model() - m2)), 1e-12);
+    EXPECT_LT(arma::max(arma::abs(model.get_m3_model() - m3)), 1e-12);
+    EXPECT_NEAR(model.get_avg_energy(), energy, 1e-12);
+}
+
+TEST(FullEnsembleEnginesTest, EnergyHistogramsAgreeAcrossEngines)
+{
+    const int nspins = 8;
+    const SamplesFile data(nspins);
+
+    std::vector<std::pair<int, double>> ge_ref, pe_ref;
+    // at q = 1 "pruned" has no cutoff and enumerates, histograms included
+    for (const std::string engine : {"enumeration", "wht", "gray", "blocked", "sectors", "pruned"})
+    {
+        RunParameters params;
+        params.run_type    = "Full_Ensemble";
+        params.nspins      = nspins;
+        params.full_engine = engine;
+        MaxEntCore core(nspins, "test");
+        FullEnsembleTrainer model(core, params, data.path());
+
+        std::mt19937 rng(3);
+        std::normal_distribution<double> dist(0.0, 0.4);
+        for (auto &x : core.h)
+            x = dist(rng);
+        for (auto &x : core.J)
+            x = dist(rng);
+        for (auto &x : core.K)
+            x = 0.2 * dist(rng);
+
+        model.computeModelAverages(1.0, true);
+
+        // every state lands in a bin within the bound, and P(E) is normalized
+        const int max_bin = core.energyBinBound(params.energy_bin);
+        std::vector<std::pair<int, double>> ge, pe;
+        double n_states = 0.0, p_total = 0.0;
+        for (const auto &[bin, weight] : model.get_GE())
+        {
+            EXPECT_LE(std::abs(bin), max_bin) << engine;
+            ge.emplace_back(bin, weight);
+            n_states += weight;
+        }
+        for (const auto &[bin, weight] : model.get_PE())
+        {
+            pe.emplace_back(bin, weight);
+            p_total += weight;
+        }
+        EXPECT_DOUBLE_EQ(n_states, double(1 << nspins)) << engine;
+        EXPECT_NEAR(p_total, 1.0, 1e-12) << engine;
+
+        if (ge_ref.empty())
+        {
+            ge_ref = ge;
+            pe_ref = pe;
+            continue;
+        }
+        ASSERT_EQ(ge.size(), ge_ref.size()) << engine;
+        ASSERT_EQ(pe.size(), pe_ref.size()) << engine;
+        for (size_t b = 0; b < ge.size(); ++b)
+        {
+            EXPECT_EQ(ge[b], ge_ref[b]) << engine;
+            EXPECT_EQ(pe[b].first, pe_ref[b].first) << engine;
+            EXPECT_NEAR(pe[b].second, pe_ref[b].second, 1e-12) << engine;
+        }
+    }
+}
@@ -62,3 +62,37 @@ TEST(GrayCodeSequenceTest, CorrectStatesFor3Spins)
 
     ASSERT_EQ(index, expected_states.size()) << "Number of generated states does not match expected.";
 }
+
+TEST(GrayCodeSequenceTest, FlippedIndexAndOffsets)
+{
+    int nspins = 5;
+    GrayCodeSequence full(nspins);
+    std::vector<std::vector<int>> states;
+    std::vector<int> previous;
+    for (auto it = full.begin(); it != full.end(); ++it)
+    {
+        const auto &[state, flipped_index] = *it;
+        if (!previous.empty())
+        {
+            // exactly one spin changed, and it is the reported one
+            ASSERT_GE(flipped_index, 0);
+            for (int i = 0; i < nspins; ++i)
+                EXPECT_EQ(state[i] != previous[i], i == flipped_index) << "step " << it.index();
+        }
+        previous = state;
+        states.push_back(state);
+    }
+    ASSERT_EQ(states.size(), 1u << nspins);
+
+    // a subsequence starts at its own Gray-code offset
+    int start = 11, end = 23;
+    GrayCodeSequence partial(nspins, start, end);
+    int index = start;
+    for (const auto &pair : partial)
+    {
+        EXPECT_EQ(pair.first, states[index]) << "State at index " << index << " does not match.";
+        EXPECT_EQ(pair.second < 0, index == start);
+        ++index;
+    }
+    EXPECT_EQ(index, end);
+}
@@ -0,0 +1,265 @@
+#include "samples_file.hpp"
+#include "trainers/heat_bath_trainer.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Chain management of the heat bath: persistent chains continue where the previous call
+// stopped, with the scalar and the replica-vectorized samplers alike.
+
+namespace
+{
+RunParameters chain_parameters(int nspins)
+{
+    RunParameters params;
+    params.run_type             = "Heat_Bath";
+    params.nspins               = nspins;
+    params.step_equilibration   = 200;
+    params.step_reequilibration = 5;
+    params.num_samples          = 50;
+    params.step_correlation     = 2;
+    params.number_repetitions   = 10;
+    return params;
+}
+
+void random_model(MaxEntCore &core, int seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+}
+
+// the samples of one call, which identify the chains
+struct ChainSamples
+{
+    arma::vec m1, m2, pK;
+
+    explicit ChainSamples(const HeatBathTrainer &model) :
+        m1(model.get_m1_model()), m2(model.get_m2_model()), pK(model.get_pK_model())
+    {
+    }
+
+    bool operator==(const ChainSamples &other) const
+    {
+        auto same = [](const arma::vec &a, const arma::vec &b)
+        {
+            if (a.n_elem != b.n_elem)
+                return false;
+            for (size_t i = 0; i < a.n_elem; ++i)
+                if (a(i) != b(i))
+                    return false;
+            return true;
+        };
+        return same(m1, other.m1) && same(m2, other.m2) && same(pK, other.pK);
+    }
+};
+} // namespace
+
+TEST(HeatBathChainsTest, FirstPersistentCallStartsNewChains)
+{
+    const int nspins = 9;
+    for (int lanes : {1, 8})
+    {
+        RunParameters params = chain_parameters(nspins);
+        params.hb_lanes      = lanes;
+        MaxEntCore core(nspins, "test");
+        HeatBathTrainer fresh(core, params, SamplesFile(nspins).path());
+        params.persistent_chains = true;
+        HeatBathTrainer persistent(core, params, SamplesFile(nspins).path());
+        random_model(core, 3);
+
+        fresh.computeModelAverages(1.0, false);
+        persistent.computeModelAverages(1.0, false);
+        EXPECT_TRUE(ChainSamples(persistent) == ChainSamples(fresh)) << lanes << " lanes";
+
+        // resumed after 5 sweeps: not the chains of a new start
+        persistent.computeModelAverages(1.0, false);
+        EXPECT_FALSE(ChainSamples(persistent) == ChainSamples(fresh)) << lanes << " lanes";
+
+        // another beta starts again
+        fresh.computeModelAverages(0.5, false);
+        persistent.computeModelAverages(0.5, false);
+        EXPECT_TRUE(ChainSamples(persistent) == ChainSamples(fresh)) << lanes << " lanes";
+    }
+}
+
+TEST(HeatBathChainsTest, PersistentChainsAgreeAcrossLanes)
+{
+    // the lanes store and resume the same states and generators as the scalar sampler,
+    // including the fields of the updated model
+    const int nspins = 9;
+    std::vector<ChainSamples> runs;
+    for (int lanes : {1, 8, 16})
+    {
+        RunParameters params     = chain_parameters(nspins);
+        params.hb_lanes          = lanes;
+        params.persistent_chains = true;
+        params.k_pairwise        = true;
+        MaxEntCore core(nspins, "test");
+        HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+        random_model(core, 3);
+        for (auto &x : core.K)
+            x = 0.1;
+
+        model.computeModelAverages(1.0, false);
+        core.h(2) += 0.3;
+        core.J(4) -= 0.2;
+        model.computeModelAverages(1.0, false);
+        runs.emplace_back(model);
+    }
+    EXPECT_TRUE(runs[1] == runs[0]);
+    EXPECT_TRUE(runs[2] == runs[0]);
+}
+
+TEST(HeatBathChainsTest, PersistentChainsStayEquilibrated)
+{
+    // with almost no re-equilibration, continued chains sample the same distribution as
+    // chains equilibrated from scratch
+    const int nspins            = 8;
+    RunParameters params        = chain_parameters(nspins);
+    params.num_samples          = 4000;
+    params.step_equilibration   = 500;
+    params.step_reequilibration = 1;
+    MaxEntCore core(nspins, "test");
+    HeatBathTrainer fresh(core, params, SamplesFile(nspins).path());
+    params.persistent_chains = true;
+    HeatBathTrainer persistent(core, params, SamplesFile(nspins).path());
+    random_model(core, 8);
+
+    fresh.computeModelAverages(1.0, false);
+    persistent.computeModelAverages(1.0, false);
+    persistent.computeModelAverages(1.0, false);
+    for (int i = 0; i < nspins; ++i)
+        EXPECT_NEAR(persistent.get_m1_model()(i), fresh.get_m1_model()(i), 0.05) << "m1 " << i;
+    for (int i = 0; i < core.nedges; ++i)
+        EXPECT_NEAR(persistent.get_m2_model()(i), fresh.get_m2_model()(i), 0.05) << "m2 " << i;
+}
+
+TEST(HeatBathChainsTest, ForkedChainsDecorrelate)
+{
+    const int nspins          = 10;
+    RunParameters params      = chain_parameters(nspins);
+    params.number_repetitions = 40;
+    params.num_samples        = 500;
+    params.step_equilibration = 500;
+    MaxEntCore core(nspins, "test");
+    HeatBathTrainer fresh(core, params, SamplesFile(nspins).path());
+    params.fork_seed_chains   = 2;
+    params.step_decorrelation = 0;
+    HeatBathTrainer forked_now(core, params, SamplesFile(nspins).path());
+    params.step_decorrelation = 200;
+    HeatBathTrainer forked(core, params, SamplesFile(nspins).path());
+    random_model(core, 8);
+
+    EXPECT_TRUE(std::isnan(forked.get_fork_overlap()));
+    EXPECT_TRUE(std::isnan(forked.get_fork_overlap_error()));
+    fresh.computeModelAverages(1.0, false);
+    forked_now.computeModelAverages(1.0, false);
+    forked.computeModelAverages(1.0, false);
+
+    // Both checks are made against the diagnostic's own standard error. Siblings sampled one
+    // sweep after the fork still resemble each other: their overlap exceeds the expectation
+    // (1/n) sum_i <s_i>^2 of independent samples, from the averages of the fresh chains. With
+    // two seeds the cross-seed mean is one draw of how the two seeds overlap, too noisy to
+    // show this at beta = 1.
+    const double independent = arma::dot(fresh.get_m1_model(), fresh.get_m1_model()) / nspins;
+    EXPECT_GT(forked_now.get_fork_overlap() - independent,
+              3.0 * forked_now.get_fork_overlap_error());
+    EXPECT_NEAR(forked.get_fork_overlap(), forked.get_independent_overlap(),
+                3.0 * forked.get_fork_overlap_error());
+    for (int i = 0; i < nspins; ++i)
+        EXPECT_NEAR(forked.get_m1_model()(i), fresh.get_m1_model()(i), 0.05) << "m1 " << i;
+    for (int i = 0; i < core.nedges; ++i)
+        EXPECT_NEAR(forked.get_m2_model()(i), fresh.get_m2_model()(i), 0.05) << "m2 " << i;
+}
+
+TEST(HeatBathChainsTest, ForkedChainsAgreeAcrossLanes)
+{
+    const int nspins = 9;
+    std::vector<ChainSamples> runs;
+    std::vector<double> overlaps;
+    for (int lanes : {1, 16})
+    {
+        RunParameters params    = chain_parameters(nspins);
+        params.hb_lanes         = lanes;
+        params.fork_seed_chains = 3;
+        MaxEntCore core(nspins, "test");
+        HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+        random_model(core, 4);
+
+        model.computeModelAverages(1.0, false);
+        runs.emplace_back(model);
+        overlaps.push_back(model.get_fork_overlap());
+    }
+    EXPECT_TRUE(runs[1] == runs[0]);
+    EXPECT_EQ(overlaps[1], overlaps[0]);
+}
+
+TEST(HeatBathChainsTest, ChainCountSplitsTheSamples)
+{
+    // every one of the num_samples * number_repetitions samples is drawn once, whatever the
+    // number of chains: the replica rows reproduce the averages
+    const int nspins = 9;
+    for (int chains : {0, 1, 7, 500, 600})
+    {
+        RunParameters params = chain_parameters(nspins);
+        params.hb_chains     = chains;
+        MaxEntCore core(nspins, "test");
+        HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+        random_model(core, 5);
+
+        model.computeModelAverages(1.0, true);
+        const utils::ReplicaView replicas = model.get_replicas();
+        ASSERT_EQ(replicas.n_rows(), params.num_samples * params.number_repetitions);
+        for (int i = 0; i < nspins; ++i)
+        {
+            double m1 = 0.0;
+            for (size_t r = 0; r < replicas.n_rows(); ++r)
+                m1 += replicas(r, i);
+            m1 /= replicas.n_rows();
+            EXPECT_NEAR(model.get_m1_model()(i), m1, 1e-12) << chains << " chains, m1 " << i;
+        }
+        EXPECT_NEAR(arma::accu(model.get_pK_model()), 1.0, 1e-12) << chains << " chains";
+    }
+}
+
+TEST(HeatBathChainsTest, UnevenChainsAgreeAcrossLanes)
+{
+    // chains of unequal length, persistent and resumed, with full and partial blocks
+    const int nspins = 9;
+    for (int chains : {3, 21})
+    {
+        std::vector<ChainSamples> runs;
+        std::vector<std::vector<utils::SpinState>> replicas;
+        for (int lanes : {1, 8, 16})
+        {
+            RunParameters params     = chain_parameters(nspins);
+            params.hb_lanes          = lanes;
+            params.hb_chains         = chains;
+            params.persistent_chains = true;
+            MaxEntCore core(nspins, "test");
+            HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+            random_model(core, 6);
+
+            model.computeModelAverages(1.0, true);
+            core.h(1) -= 0.2;
+            model.computeModelAverages(1.0, true);
+            runs.emplace_back(model);
+            replicas.emplace_back();
+            for (size_t row = 0; row < model.get_replicas().n_rows(); ++row)
+                replicas.back().push_back(model.get_replicas().row(row));
+        }
+        for (size_t r = 1; r < runs.size(); ++r)
+        {
+            EXPECT_TRUE(runs[r] == runs[0]) << chains << " chains, run " << r;
+            for (size_t row = 0; row < replicas[0].size(); ++row)
+                ASSERT_TRUE(replicas[r][row] == replicas[0][row])
+                    << chains << " chains, run " << r << ", row " << row;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "samples_file.hpp"
+#include "trainers/heat_bath_trainer.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// The replica-vectorized heat bath runs the chains of the scalar sampler: each chain keeps
+// its generator, so the samples (moments, P(K), replicas) must be identical and only the
+// summation order of the energies may differ.
+
+namespace
+{
+// the averages and replicas of one run with the given number of lanes
+struct LaneRun
+{
+    arma::vec m1, m2, m3, pK;
+    double energy, energy_sq;
+    std::vector<utils::SpinState> states; // the replica rows
+};
+
+LaneRun run_lanes(int lanes, bool k_pairwise, bool triplets)
+{
+    const int nspins = 11;
+    RunParameters params;
+    params.run_type           = "Heat_Bath";
+    params.nspins             = nspins;
+    params.k_pairwise         = k_pairwise;
+    params.step_equilibration = 50;
+    params.num_samples        = 40;
+    params.step_correlation   = 3;
+    params.number_repetitions = 19; // full blocks and a partial one
+    params.hb_lanes           = lanes;
+    MaxEntCore core(nspins, "test");
+    HeatBathTrainer model(core, params, SamplesFile(nspins).path());
+
+    std::mt19937 rng(5);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+    for (auto &x : core.K)
+        x = k_pairwise ? 0.2 * dist(rng) : 0.0;
+
+    model.computeModelAverages(1.0, triplets);
+    std::vector<utils::SpinState> states;
+    for (size_t r = 0; r < model.get_replicas().n_rows(); ++r)
+        states.push_back(model.get_replicas().row(r));
+    return {model.get_m1_model(), model.get_m2_model(),   model.get_m3_model(),
+            model.get_pK_model(), model.get_avg_energy(), model.get_avg_energy_sq(),
+            states};
+}
+
+void compare_lanes_with_scalar(int lanes, bool k_pairwise, bool triplets)
+{
+    const LaneRun scalar = run_lanes(1, k_pairwise, triplets);
+    const LaneRun vector = run_lanes(lanes, k_pairwise, triplets);
+    const std::string what = std::to_string(lanes) + " lanes, k_pairwise " +
+                             std::to_string(k_pairwise) + ", triplets " +
+                             std::to_string(triplets);
+    for (size_t i = 0; i < scalar.m1.n_elem; ++i)
+        EXPECT_EQ(vector.m1(i), scalar.m1(i)) << what << " m1 " << i;
+    for (size_t i = 0; i < scalar.m2.n_elem; ++i)
+        EXPECT_EQ(vector.m2(i), scalar.m2(i)) << what << " m2 " << i;
+    for (size_t i = 0; i < scalar.pK.n_elem; ++i)
+        EXPECT_EQ(vector.pK(i), scalar.pK(i)) << what << " pK " << i;
+    EXPECT_NEAR(vector.energy, scalar.energy, 1e-12) << what;
+    EXPECT_NEAR(vector.energy_sq, scalar.energy_sq, 1e-12) << what;
+    if (triplets)
+    {
+        for (size_t i = 0; i < scalar.m3.n_elem; ++i)
+            EXPECT_EQ(vector.m3(i), scalar.m3(i)) << what << " m3 " << i;
+        // the rows are chain after chain in both samplers, with any number of threads
+        for (size_t r = 0; r < scalar.states.size(); ++r)
+            ASSERT_TRUE(vector.states[r] == scalar.states[r]) << what << " row " << r;
+    }
+}
+} // namespace
+
+TEST(HeatBathLanesTest, LanesReproduceScalarChains)
+{
+    for (int lanes : {8, 16})
+        for (bool k_pairwise : {false, true})
+            for (bool triplets : {false, true})
+                compare_lanes_with_scalar(lanes, k_pairwise, triplets);
+}
@@ -0,0 +1,115 @@
+#include "samples_file.hpp"
+#include "trainers/full_ensemble_trainer.hpp"
+#include "trainers/heat_bath_chain.hpp"
+#include "trainers/heat_bath_trainer.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+// The heat-bath sweep updates the local fields, the pairwise energy and the number of up
+// spins flip by flip: they must stay equal to a fresh evaluation of the state, and the
+// samples must follow the exact distribution of the full enumeration.
+
+namespace
+{
+// exposes the trainers' reference energy of a state
+class EnergyProbe : public HeatBathTrainer
+{
+  public:
+    using HeatBathTrainer::energyAllPairs;
+    using HeatBathTrainer::HeatBathTrainer;
+};
+
+void random_model(MaxEntCore &core, bool k_pairwise, int seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> dist(0.0, 0.4);
+    for (auto &x : core.h)
+        x = dist(rng);
+    for (auto &x : core.J)
+        x = dist(rng);
+    for (auto &x : core.K)
+        x = k_pairwise ? 0.3 * std::abs(dist(rng)) : 0.0;
+    core.syncCouplings();
+}
+
+template <int N, bool KPairwise> void check_incremental_state(int nspins)
+{
+    RunParameters params;
+    params.run_type   = "Heat_Bath";
+    params.nspins     = nspins;
+    params.k_pairwise = KPairwise;
+    MaxEntCore core(nspins, "test");
+    EnergyProbe probe(core, params, SamplesFile(nspins).path());
+    random_model(core, KPairwise, 2);
+
+    const std::string what = std::to_string(nspins) + " spins, k_pairwise " +
+                             std::to_string(KPairwise);
+    HeatBathChain<N, KPairwise> chain(core, 0.8);
+    chain.start(utils::SpinState(nspins, -1), utils::Philox(3, 0));
+    for (int sweep = 0; sweep < 50; ++sweep)
+    {
+        chain.sweep();
+        EXPECT_NEAR(chain.energy(), probe.energyAllPairs(chain.s), 1e-10)
+            << what << ", sweep " << sweep;
+        EXPECT_EQ(chain.ki, chain.s.numUp()) << what << ", sweep " << sweep;
+        for (int i = 0; i < nspins; ++i)
+        {
+            const double f = utils::denseField<0>(core.h(i), core.J_dense.row(i),
+                                                  chain.s.data(), nspins);
+            EXPECT_NEAR(chain.fields()[i], f, 1e-10)
+                << what << ", sweep " << sweep << ", f " << i;
+        }
+    }
+}
+
+void compare_with_enumeration(bool k_pairwise)
+{
+    const int nspins  = 8;
+    const double beta = 1.0;
+    RunParameters params;
+    params.run_type           = "Heat_Bath";
+    params.nspins             = nspins;
+    params.k_pairwise         = k_pairwise;
+    params.step_equilibration = 200;
+    params.num_samples        = 5000;
+    params.step_correlation   = 2;
+    params.number_repetitions = 40;
+    MaxEntCore core(nspins, "test");
+    HeatBathTrainer sampler(core, params, SamplesFile(nspins).path());
+    params.run_type = "Full_Ensemble";
+    FullEnsembleTrainer exact(core, params, SamplesFile(nspins).path());
+    random_model(core, k_pairwise, 9);
+
+    exact.computeModelAverages(beta, false);
+    sampler.computeModelAverages(beta, false);
+
+    // 200000 samples: a few standard errors of a +-1 average, 1 / sqrt(2e5) ~ 0.002, with
+    // room for the autocorrelation left at two sweeps apart
+    const double tol       = 0.02;
+    const std::string what = std::string("k_pairwise ") + (k_pairwise ? "on" : "off");
+    for (int i = 0; i < nspins; ++i)
+        EXPECT_NEAR(sampler.get_m1_model()(i), exact.get_m1_model()(i), tol)
+            << what << ", m1 " << i;
+    for (int i = 0; i < core.nedges; ++i)
+        EXPECT_NEAR(sampler.get_m2_model()(i), exact.get_m2_model()(i), tol)
+            << what << ", m2 " << i;
+    for (int k = 0; k <= nspins; ++k)
+        EXPECT_NEAR(sampler.get_pK_model()(k), exact.get_pK_model()(k), tol)
+            << what << ", pK " << k;
+}
+} // namespace
+
+TEST(HeatBathSweepTest, IncrementalStateMatchesFullEvaluation)
+{
+    check_incremental_state<0, false>(13);
+    check_incremental_state<0, true>(13);
+    check_incremental_state<10, false>(10);
+    check_incremental_state<10, true>(10);
+}
+
+TEST(HeatBathSweepTest, SamplesMatchFullEnumeration)
+{
+    compare_with_enumeration(false);
+    compare_with_enumeration(true);
+}
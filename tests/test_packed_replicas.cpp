@@ -0,0 +1,89 @@
+#include "utils/correlation_histogram.hpp"
+#include "utils/packed_replicas.hpp"
+#include <armadillo>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+// Bit-packed replicas against the same states kept as ints: element access, overlaps and
+// the correlation histogram, with one, two and three words per row.
+
+namespace
+{
+struct Replicas
+{
+    utils::PackedReplicas packed;
+    arma::Mat<int> ints;
+};
+
+Replicas random_replicas(std::size_t rows, int nspins, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    Replicas R;
+    R.packed.resize(rows, nspins);
+    R.ints.set_size(rows, nspins);
+    for (std::size_t r = 0; r < rows; ++r)
+    {
+        utils::SpinState s(nspins);
+        for (int i = 0; i < nspins; ++i)
+        {
+            s.set(i, (rng() % 3 == 0) ? -1 : 1); // biased towards +1
+            R.ints(r, i) = s(i);
+        }
+        R.packed.set_row(r, s);
+    }
+    return R;
+}
+} // namespace
+
+TEST(PackedReplicasTest, MatchIntStorage)
+{
+    for (int nspins : {5, 64, 70, 130})
+    {
+        const Replicas R              = random_replicas(150, nspins, nspins);
+        const utils::ReplicaView view = R.packed.view();
+        ASSERT_EQ(view.n_rows(), 150u);
+        ASSERT_EQ(view.n_spins(), nspins);
+        for (std::size_t r = 0; r < view.n_rows(); ++r)
+        {
+            const utils::SpinState s = view.row(r);
+            for (int i = 0; i < nspins; ++i)
+            {
+                ASSERT_EQ(view(r, i), R.ints(r, i)) << nspins << " spins, row " << r;
+                ASSERT_EQ(s(i), R.ints(r, i)) << nspins << " spins, row " << r;
+            }
+        }
+        for (std::size_t a = 0; a < 20; ++a)
+            for (std::size_t b = 0; b < 20; ++b)
+            {
+                int dot = 0;
+                for (int i = 0; i < nspins; ++i)
+                    dot += R.ints(a, i) * R.ints(b, i);
+                EXPECT_EQ(view.overlap(a, b), dot) << nspins << " spins, rows " << a << " " << b;
+            }
+    }
+}
+
+TEST(PackedReplicasTest, NewStorageIsAllDown)
+{
+    utils::PackedReplicas packed;
+    packed.resize(3, 70);
+    for (std::size_t r = 0; r < 3; ++r)
+        EXPECT_TRUE(packed.view().row(r) == utils::SpinState(70, -1));
+}
+
+TEST(PackedReplicasTest, CorrelationHistogramMatchesIntMatrix)
+{
+    for (int nspins : {9, 70})
+    {
+        const Replicas R            = random_replicas(60, nspins, 11);
+        const auto [q_int, p_int]   = correlation_histogram<int>(R.ints, 2.0, true);
+        const auto [q_bits, p_bits] = correlation_histogram(R.packed.view(), 2.0);
+        ASSERT_EQ(q_bits.size(), q_int.size()) << nspins << " spins";
+        for (std::size_t k = 0; k < q_int.size(); ++k)
+        {
+            EXPECT_EQ(q_bits[k], q_int[k]) << nspins << " spins, bin " << k;
+            EXPECT_EQ(p_bits[k], p_int[k]) << nspins << " spins, bin " << k;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#include "utils/philox.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+// Philox4x32-10 against the known-answer vectors of the reference implementation (Random123),
+// and the stream interface the samplers rely on: any position reproducible, batches equal to
+// single draws.
+
+namespace
+{
+void expect_block(std::array<uint32_t, 4> ctr, std::array<uint32_t, 2> key,
+                  std::array<uint32_t, 4> expected)
+{
+    const auto x = utils::philox4x32(ctr, key);
+    for (int w = 0; w < 4; ++w)
+        EXPECT_EQ(x[w], expected[w]) << "word " << w;
+}
+} // namespace
+
+TEST(PhiloxTest, KnownAnswers)
+{
+    expect_block({0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+    expect_block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+                 {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+    expect_block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+                 {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+}
+
+TEST(PhiloxTest, BatchesMatchSingleDraws)
+{
+    // odd lengths and odd starting positions exercise the spare half-block
+    utils::Philox single(7, 3);
+    std::vector<double> expected(1001);
+    for (auto &u : expected)
+        u = single.uniform();
+
+    utils::Philox batched(7, 3);
+    std::vector<double> u(expected.size());
+    size_t done = 0;
+    for (size_t n : {1, 6, 33, 0, 250, 711})
+    {
+        batched.uniforms(u.data() + done, n);
+        done += n;
+    }
+    ASSERT_EQ(done, expected.size());
+    EXPECT_EQ(batched.tell(), done);
+    for (size_t k = 0; k < u.size(); ++k)
+        ASSERT_EQ(u[k], expected[k]) << "uniform " << k;
+    EXPECT_TRUE(batched == single);
+}
+
+TEST(PhiloxTest, DiscardSkipsAhead)
+{
+    utils::Philox walked(11, 0);
+    std::vector<double> u(64);
+    walked.uniforms(u.data(), u.size());
+    for (uint64_t k : {0, 1, 2, 17, 63})
+    {
+        utils::Philox skipped(11, 0);
+        skipped.discard(k);
+        EXPECT_EQ(skipped.uniform(), u[k]) << "position " << k;
+    }
+
+    // far positions cost nothing and land on the same number
+    utils::Philox far(11, 0), near(11, 0);
+    far.discard(uint64_t(1) << 40);
+    near.discard((uint64_t(1) << 40) - 1);
+    near.uniform();
+    EXPECT_EQ(far.uniform(), near.uniform());
+}
+
+TEST(PhiloxTest, StreamsAreDistinctAndUniform)
+{
+    const size_t n = 100000;
+    std::vector<double> a(n), b(n);
+    utils::Philox(1, 0).uniforms(a.data(), n);
+    utils::Philox(1, 1).uniforms(b.data(), n);
+
+    size_t same = 0;
+    double mean = 0.0, mean_sq = 0.0;
+    for (size_t k = 0; k < n; ++k)
+    {
+        ASSERT_GE(a[k], 0.0);
+        ASSERT_LT(a[k], 1.0);
+        same += (a[k] == b[k]);
+        mean += a[k];
+        mean_sq += a[k] * a[k];
+    }
+    mean /= n;
+    mean_sq /= n;
+    EXPECT_EQ(same, 0u);
+    EXPECT_NEAR(mean, 0.5, 0.005);
+    EXPECT_NEAR(mean_sq - mean * mean, 1.0 / 12.0, 0.002);
+
+    utils::Philox rng(5, 2);
+    std::vector<int> counts(7, 0);
+    for (int k = 0; k < 70000; ++k)
+        ++counts.at(rng.below(7));
+    for (int c : counts)
+        EXPECT_NEAR(c, 10000, 500);
+}
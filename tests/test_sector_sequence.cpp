@@ -0,0 +1,42 @@
+#include "utils/sector_sequence.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(SectorSequenceTest, VisitsEverySectorStateInIndexOrder)
+{
+    int nspins = 9;
+    for (int n_down = 0; n_down <= nspins; ++n_down)
+    {
+        std::vector<uint64_t> expected;
+        for (uint64_t x = 0; x < (uint64_t(1) << nspins); ++x)
+            if (__builtin_popcountll(x) == n_down)
+                expected.push_back(x);
+        ASSERT_EQ(SectorSequence::binomial(nspins, n_down), expected.size());
+
+        std::vector<uint64_t> visited;
+        for (const auto &s : SectorSequence(nspins, n_down, 0, expected.size()))
+        {
+            EXPECT_EQ(s.numUp(), nspins - n_down);
+            visited.push_back(s.index());
+        }
+        EXPECT_EQ(visited, expected) << "n_down " << n_down;
+
+        // every rank starts at its own index, and a piece continues from there
+        for (uint64_t r = 0; r < expected.size(); ++r)
+            EXPECT_EQ(SectorSequence::unrank(n_down, r), expected[r]);
+        if (expected.size() > 3)
+        {
+            std::vector<uint64_t> piece;
+            for (const auto &s : SectorSequence(nspins, n_down, 2, 2))
+                piece.push_back(s.index());
+            EXPECT_EQ(piece, std::vector<uint64_t>(expected.begin() + 2, expected.begin() + 4));
+        }
+    }
+}
+
+TEST(SectorSequenceTest, BinomialsAreExact)
+{
+    EXPECT_EQ(SectorSequence::binomial(40, 20), 137846528820ULL);
+    EXPECT_EQ(SectorSequence::binomial(64, 32), 1832624140942590534ULL);
+    EXPECT_EQ(SectorSequence::binomial(5, 6), 0u);
+}
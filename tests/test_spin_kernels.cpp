@@ -0,0 +1,130 @@
+#include "core/max_ent_core.hpp"
+#include "utils/spin_kernels.hpp"
+#include "utils/spin_state.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// The size-specialized kernels against the generic ones (N = 0) on the same states: the
+// summation order is the same, so the results must agree exactly.
+
+namespace
+{
+// h_i + sum_{j != i} J_ij s_j from the packed J; edges_i is column i of the edge index
+double reference_field(int i, const double *h, const double *J, const int *edges_i,
+                       const int8_t *s, int n)
+{
+    double f = h[i];
+    for (int j = 0; j < n; ++j)
+        if (edges_i[j] != -1)
+            f += J[edges_i[j]] * s[j];
+    return f;
+}
+
+template <int N> void compare_with_generic()
+{
+    constexpr int n = N;
+    std::mt19937 rng(N);
+    std::normal_distribution<double> dist(0.0, 0.5);
+    std::vector<double> h(n), J(n * (n - 1) / 2);
+    for (auto &x : h)
+        x = dist(rng);
+    for (auto &x : J)
+        x = dist(rng);
+
+    // the same couplings as a dense symmetric matrix with a zero diagonal
+    std::vector<double> J_dense(n * n, 0.0);
+    int idx = 0;
+    for (int i = 0; i < n - 1; ++i)
+        for (int j = i + 1; j < n; ++j)
+        {
+            J_dense[i * n + j] = J[idx];
+            J_dense[j * n + i] = J[idx++];
+        }
+
+    std::vector<double> m1(n), m2(J.size()), m3(n * (n - 1) * (n - 2) / 6);
+    auto m1_ref = m1, m2_ref = m2, m3_ref = m3;
+    for (int trial = 0; trial < 20; ++trial)
+    {
+        auto s = utils::SpinState::fromIndex(n, rng());
+        EXPECT_EQ(utils::pairEnergy<N>(h.data(), J.data(), s.data(), n),
+                  utils::pairEnergy<0>(h.data(), J.data(), s.data(), n));
+        // the simd reduction may sum in another order once n is a constant
+        for (int i = 0; i < n; ++i)
+            EXPECT_NEAR(utils::denseField<N>(h[i], &J_dense[i * n], s.data(), n),
+                        utils::denseField<0>(h[i], &J_dense[i * n], s.data(), n), 1e-12);
+
+        double w = dist(rng);
+        utils::addMoments<N>(w, 2.0 * w, s.data(), m1.data(), m2.data(), n);
+        utils::addMoments<0>(w, 2.0 * w, s.data(), m1_ref.data(), m2_ref.data(), n);
+        utils::addTriplets<N>(w, s.data(), m3.data(), n);
+        utils::addTriplets<0>(w, s.data(), m3_ref.data(), n);
+    }
+    EXPECT_EQ(m1, m1_ref);
+    EXPECT_EQ(m2, m2_ref);
+    EXPECT_EQ(m3, m3_ref);
+}
+} // namespace
+
+TEST(SpinKernelsTest, SpecializedMatchGeneric)
+{
+    compare_with_generic<10>();
+    compare_with_generic<16>();
+    compare_with_generic<24>();
+}
+
+TEST(SpinKernelsTest, DispatchSelectsSpecialization)
+{
+    EXPECT_EQ(utils::specializedSpinCount(16), 16);
+    EXPECT_EQ(utils::specializedSpinCount(17), 0);
+    EXPECT_EQ(utils::spinKernels(64).spin_count, 64);
+    EXPECT_EQ(utils::spinKernels(12).spin_count, 0);
+
+    EXPECT_EQ(MaxEntCore(20, "test").kernelName(), "n=20");
+    EXPECT_EQ(MaxEntCore(12, "test").kernelName(), "generic");
+}
+
+TEST(SpinKernelsTest, DenseCouplingsFollowJ)
+{
+    int n = 13;
+    MaxEntCore core(n, "test");
+    std::mt19937 rng(31);
+    std::normal_distribution<double> dist(0.0, 0.5);
+    for (auto &x : core.h)
+        x = dist(rng);
+
+    auto check = [&](const std::string &when)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(core.J_dense.row(i)) % 64, 0u) << when;
+            EXPECT_EQ(core.J_dense.row(i)[i], 0.0) << when;
+        }
+        for (int trial = 0; trial < 10; ++trial)
+        {
+            auto s = utils::SpinState::fromIndex(n, rng());
+            for (int i = 0; i < n; ++i)
+            {
+                double f = reference_field(i, core.h.memptr(), core.J.memptr(),
+                                           core.edges.colptr(i), s.data(), n);
+                EXPECT_NEAR(utils::denseField<0>(core.h(i), core.J_dense.row(i), s.data(), n), f,
+                            1e-12)
+                    << when;
+                EXPECT_NEAR(utils::denseField<0>(core.h(i), core.J_dense_f.row(i), s.data(), n),
+                            f, 1e-5)
+                    << when;
+            }
+        }
+    };
+
+    for (auto &x : core.J)
+        x = dist(rng);
+    core.syncCouplings();
+    check("full copy");
+
+    core.J(7) += 0.3; // one coordinate-descent step
+    core.syncCouplings();
+    check("patched entry");
+}
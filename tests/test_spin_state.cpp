@@ -0,0 +1,56 @@
+#include "utils/binary_permutations_sequence.hpp"
+#include "utils/spin_state.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+
+TEST(SpinStateTest, IndexFollowsBinaryPermutationsConvention)
+{
+    int nspins = 10;
+    uint64_t x = 0b1000110101; // s_0, s_4, s_5, s_7, s_9 = -1
+    auto s     = utils::SpinState::fromIndex(nspins, x);
+
+    EXPECT_EQ(s.size(), nspins);
+    EXPECT_EQ(s.index(), x);
+    for (int i = 0; i < nspins; ++i)
+        EXPECT_EQ(s(i), ((x >> (nspins - 1 - i)) & 1) ? -1 : 1) << "spin " << i;
+    EXPECT_EQ(s.numUp(), nspins - 5);
+    EXPECT_DOUBLE_EQ(s.magnetization(), 0.0);
+
+    uint64_t index = 0;
+    for (const auto &state : BinaryPermutationsSequence(nspins))
+        EXPECT_EQ(state.index(), index++);
+}
+
+TEST(SpinStateTest, FlipAndSetKeepBitsAndSpinsInSync)
+{
+    int nspins = 150; // three words
+    utils::SpinState s(nspins, -1);
+    EXPECT_EQ(s.numUp(), 0);
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> spin(0, nspins - 1);
+    for (int step = 0; step < 1000; ++step)
+    {
+        int i = spin(rng);
+        if (step % 2)
+            s.flip(i);
+        else
+            s.set(i, (rng() & 1) ? 1 : -1);
+
+        int up = 0;
+        for (int v : s)
+            up += (v == 1);
+        ASSERT_EQ(s.numUp(), up) << "step " << step;
+    }
+
+    utils::SpinState copy = s;
+    EXPECT_TRUE(copy == s);
+    copy.flip(nspins - 1);
+    EXPECT_FALSE(copy == s);
+}
+
+TEST(SpinStateTest, RejectsMoreSpinsThanCapacity)
+{
+    EXPECT_THROW(utils::SpinState(utils::SpinState::max_spins + 1), std::length_error);
+}
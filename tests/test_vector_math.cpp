@@ -0,0 +1,133 @@
+#include "utils/utilities.hpp"
+#include "utils/vector_math.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+// The batched kernels against the scalar utils::exp_q / log_q and the logistic formula of
+// the heat-bath update, in double and float.
+
+namespace
+{
+// relative error, with |reference| below min_abs treated as min_abs
+template <typename T> double rel_err(T value, T reference, double min_abs)
+{
+    if (std::isinf(reference) || std::isinf(value))
+        return (value == reference) ? 0.0 : 1.0;
+    return std::abs(double(value) - double(reference)) /
+           std::max(std::abs(double(reference)), min_abs);
+}
+
+template <typename T> std::vector<T> uniform(T lo, T hi, int n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(lo, hi);
+    std::vector<T> x(n);
+    for (auto &v : x)
+        v = static_cast<T>(dist(rng));
+    return x;
+}
+
+template <typename T> void check_exp_q(double q, T lo, T hi, double tol)
+{
+    auto x = uniform<T>(lo, hi, 4099, 1); // odd length: exercises the loop tails
+    std::vector<T> y(x.size());
+    utils::exp_q_batch(x.data(), y.data(), x.size(), static_cast<T>(q));
+    double worst = 0.0;
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        T ref = static_cast<T>(utils::exp_q(double(x[i]), q));
+        worst = std::max(worst, rel_err(y[i], ref, double(std::numeric_limits<T>::min())));
+    }
+    EXPECT_LT(worst, tol) << "q = " << q << " on [" << lo << ", " << hi << "]";
+}
+} // namespace
+
+TEST(VectorMathTest, ExpQMatchesScalarDouble)
+{
+    check_exp_q<double>(1.0, -740.0, 709.0, 1e-14);
+    check_exp_q<double>(1.0, -5.0, 5.0, 1e-15);
+    // q != 1 away from the cutoff 1 + (1-q) x = 0, where the result is ill-conditioned
+    check_exp_q<double>(0.7, -3.0, 20.0, 1e-13);
+    check_exp_q<double>(0.5, -1.8, 50.0, 1e-13);
+    check_exp_q<double>(1.3, -2.0, 3.0, 1e-13);
+}
+
+TEST(VectorMathTest, ExpQMatchesScalarFloat)
+{
+    check_exp_q<float>(1.0, -87.0, 88.0, 1e-6);
+    // exp(log(b) / (1-q)) amplifies the float rounding of b and log(b) by |log(b) / (1-q)|
+    check_exp_q<float>(0.7, -3.0, 20.0, 1e-5);
+    check_exp_q<float>(1.3, -2.0, 3.0, 1e-5);
+}
+
+TEST(VectorMathTest, ExpQCutsOffLikeScalar)
+{
+    // beyond 1 + (1-q) x <= 0 the weight is exactly zero for q < 1
+    std::vector<double> x = {-3.0, -10.0 / 3.0, -4.0, -100.0};
+    std::vector<double> y(x.size());
+    utils::exp_q_batch(x.data(), y.data(), x.size(), 0.7);
+    EXPECT_GT(y[0], 0.0);
+    for (size_t i = 1; i < x.size(); ++i)
+        EXPECT_EQ(y[i], utils::exp_q(x[i], 0.7)) << "x = " << x[i];
+}
+
+TEST(VectorMathTest, LogisticMatchesScalar)
+{
+    auto x = uniform<double>(-60.0, 60.0, 1001, 2);
+    std::vector<double> y(x.size());
+    utils::logistic_batch(x.data(), y.data(), x.size());
+    for (size_t i = 0; i < x.size(); ++i)
+        EXPECT_NEAR(y[i], 1.0 / (1.0 + std::exp(-x[i])), 1e-15) << "x = " << x[i];
+
+    auto xf = uniform<float>(-30.0f, 30.0f, 1001, 3);
+    std::vector<float> yf(xf.size());
+    utils::logistic_batch(xf.data(), yf.data(), xf.size());
+    for (size_t i = 0; i < xf.size(); ++i)
+        EXPECT_NEAR(yf[i], 1.0f / (1.0f + std::exp(-xf[i])), 1e-6f) << "x = " << xf[i];
+}
+
+TEST(VectorMathTest, LogQMatchesScalar)
+{
+    for (double q : {1.0, 0.7, 1.3})
+    {
+        auto x = uniform<double>(1e-12, 1e3, 2001, 4);
+        x.push_back(1e-310); // denormal
+        x.push_back(1.0);
+        std::vector<double> y(x.size());
+        utils::log_q_batch(x.data(), y.data(), x.size(), q);
+        for (size_t i = 0; i < x.size(); ++i)
+            EXPECT_LT(rel_err(y[i], utils::log_q(x[i], q), 1e-300), 1e-13)
+                << "q = " << q << " x = " << x[i];
+
+        auto xf = uniform<float>(1e-6f, 1e3f, 2001, 5);
+        std::vector<float> yf(xf.size());
+        utils::log_q_batch(xf.data(), yf.data(), xf.size(), float(q));
+        for (size_t i = 0; i < xf.size(); ++i)
+            EXPECT_LT(rel_err(yf[i], float(utils::log_q(double(xf[i]), q)), 1.0), 2e-6)
+                << "q = " << q << " x = " << xf[i];
+    }
+}
+
+TEST(VectorMathTest, SpecialValues)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> x = {-inf, -1000.0, 0.0, 710.0, inf, std::nan("")};
+    std::vector<double> y(x.size());
+    utils::exp_q_batch(x.data(), y.data(), x.size(), 1.0);
+    EXPECT_EQ(y[0], 0.0);
+    EXPECT_EQ(y[1], 0.0);
+    EXPECT_EQ(y[2], 1.0);
+    EXPECT_EQ(y[3], inf);
+    EXPECT_EQ(y[4], inf);
+    EXPECT_TRUE(std::isnan(y[5]));
+
+    std::vector<double> l = {0.0, -1.0, inf, 1.0};
+    utils::log_q_batch(l.data(), l.data(), l.size(), 1.0); // in place
+    EXPECT_EQ(l[0], -inf);
+    EXPECT_TRUE(std::isnan(l[1]));
+    EXPECT_EQ(l[2], inf);
+    EXPECT_EQ(l[3], 0.0);
+}
@@ -0,0 +1,40 @@
+#include "utils/walsh_hadamard.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+TEST(WalshHadamardTest, TransformTwiceScalesByLength)
+{
+    int n_bits = 14; // larger than one block, exercises both stages
+    size_t total = size_t(1) << n_bits;
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> a(total), b;
+    for (auto &x : a)
+        x = dist(rng);
+    b = a;
+
+    utils::fast_walsh_hadamard(b.data(), n_bits);
+    utils::fast_walsh_hadamard(b.data(), n_bits);
+
+    for (size_t x = 0; x < total; ++x)
+        EXPECT_NEAR(b[x] / total, a[x], 1e-12) << "x = " << x;
+}
+
+TEST(WalshHadamardTest, MatchesDefinition)
+{
+    int n_bits   = 4;
+    size_t total = size_t(1) << n_bits;
+    std::vector<double> a(total), y(total, 0.0);
+    for (size_t S = 0; S < total; ++S)
+        a[S] = 0.5 * S - 1.0;
+
+    for (size_t x = 0; x < total; ++x)
+        for (size_t S = 0; S < total; ++S)
+            y[x] += (__builtin_popcountll(x & S) % 2 ? -1.0 : 1.0) * a[S];
+
+    utils::fast_walsh_hadamard(a.data(), n_bits);
+    for (size_t x = 0; x < total; ++x)
+        EXPECT_DOUBLE_EQ(a[x], y[x]) << "x = " << x;
+}